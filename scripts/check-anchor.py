@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Regression check for lcs-anchor -x on small related pairs.
+
+Pairs come from lcs-generate with a random size, mutation rate and seed.
+Every -x result must be a common subsequence of both inputs, its length
+must be the printed value, and the value must match lcs-serial.
+
+    check-anchor.py --bin ./build --runs 400
+
+Exits 1 and prints the failing inputs when any run is wrong.
+"""
+
+import argparse
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+
+def is_subsequence(subsequence, sequence):
+    position = 0
+    for letter in subsequence:
+        position = sequence.find(letter, position) + 1
+        if position == 0:
+            return False
+    return True
+
+
+def read_pair(path):
+    with open(path) as file:
+        lines = file.read().split("\n")
+    return lines[1], lines[2]
+
+
+def run(command):
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL,
+                            universal_newlines=True, check=True)
+    lines = result.stdout.split("\n")
+    return int(lines[0]), lines[1]
+
+
+def check(args, path):
+    height, width = read_pair(path)
+    value, subsequence = run([os.path.join(args.bin, "lcs-anchor"), path, str(args.k), "-x"])
+    expected, _ = run([os.path.join(args.bin, "lcs-serial"), path])
+    problems = []
+    if len(subsequence) != value:
+        problems.append("length %d, value %d" % (len(subsequence), value))
+    if not is_subsequence(subsequence, height) or not is_subsequence(subsequence, width):
+        problems.append("not a common subsequence")
+    if value != expected:
+        problems.append("value %d, lcs-serial %d" % (value, expected))
+    return problems
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--bin", default=".", help="directory with lcs-anchor, lcs-serial and lcs-generate")
+    parser.add_argument("--runs", type=int, default=400)
+    parser.add_argument("--k", type=int, default=2, help="seed length, short seeds give backbones that can be beaten")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    failures = 0
+    with tempfile.TemporaryDirectory() as directory:
+        for run_number in range(args.runs):
+            height = rng.randint(1, 200)
+            width = rng.randint(1, 200)
+            mutation = rng.choice([0.01, 0.05, 0.1, 0.3, 0.6])
+            path = os.path.join(directory, "pair.%d.in" % run_number)
+            subprocess.run([os.path.join(args.bin, "lcs-generate"), str(height), str(width), "4", str(mutation),
+                            str(rng.randint(1, 1 << 30)), path], check=True, stdout=subprocess.DEVNULL)
+            problems = check(args, path)
+            if problems:
+                failures += 1
+                with open(path) as file:
+                    print("%s: %s\n%s" % (path, ", ".join(problems), file.read()), file=sys.stderr)
+    print("%d of %d runs wrong" % (failures, args.runs))
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""Strong and weak scaling sweeps for lcs-omp and lcs-mpi.
+
+Inputs come from lcs-generate and are cached in the output directory.
+Every run is timed on the wall clock, the best of --repeat is kept, and
+the LCS length is checked against the one-worker run of the same input.
+
+    scaling.py --bin ./build --sizes 8000 16000 --threads 1 2 4 8 --ranks 1 2 4
+    scaling.py --bin ./build --mode weak --sizes 4000 --threads 1 2 4 8
+
+Writes scaling.csv and, when matplotlib is available, efficiency.png.
+"""
+
+import argparse
+import csv
+import math
+import os
+import subprocess
+import sys
+import time
+
+
+def generate(args, height, width):
+    path = os.path.join(args.out, "gen.%d.%d.%d.%g.%d.in" % (height, width, args.alphabet, args.mutation, args.seed))
+    if not os.path.exists(path):
+        subprocess.run([os.path.join(args.bin, "lcs-generate"), str(height), str(width), str(args.alphabet),
+                        str(args.mutation), str(args.seed), path], check=True)
+    return path
+
+
+def run(command, env):
+    start = time.perf_counter()
+    result = subprocess.run(command, env=env, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL,
+                            universal_newlines=True, check=True)
+    return time.perf_counter() - start, result.stdout.split("\n", 1)[0]
+
+
+def best_of(args, engine, workers, path):
+    env = dict(os.environ)
+    if engine == "omp":
+        env["OMP_NUM_THREADS"] = str(workers)
+        command = [os.path.join(args.bin, "lcs-omp"), path]
+    else:
+        env["OMP_NUM_THREADS"] = "1"
+        command = args.mpirun.split() + ["-np", str(workers), os.path.join(args.bin, "lcs-mpi"), path]
+    times, length = [], None
+    for _ in range(args.repeat):
+        seconds, length = run(command, env)
+        times.append(seconds)
+    return min(times), length
+
+
+def sweep(args):
+    rows = []
+    engines = [("omp", args.threads)] if args.threads else []
+    engines += [("mpi", args.ranks)] if args.ranks else []
+    for engine, counts in engines:
+        for size in args.sizes:
+            base_time, base_length = None, None
+            for workers in counts:
+                # weak scaling keeps the cells per worker of the one-worker size
+                side = size if args.mode == "strong" else int(size * math.sqrt(workers / counts[0]))
+                height, width = side, int(side * args.ratio)
+                path = generate(args, height, width)
+                seconds, length = best_of(args, engine, workers, path)
+                if base_time is None:
+                    base_time, base_workers = seconds, workers
+                if args.mode == "strong":
+                    if base_length is None:
+                        base_length = length
+                    elif length != base_length:
+                        print("warning: %s with %d workers found %s, expected %s" % (engine, workers, length, base_length),
+                              file=sys.stderr)
+                    speedup = base_time / seconds
+                    efficiency = speedup * base_workers / workers
+                else:
+                    speedup = base_time / seconds * workers / base_workers
+                    efficiency = base_time / seconds
+                rows.append({"engine": engine, "mode": args.mode, "size": size, "height": height, "width": width,
+                             "workers": workers, "seconds": "%.3f" % seconds, "speedup": "%.2f" % speedup,
+                             "efficiency": "%.2f" % efficiency, "length": length})
+                print("%-4s %-6s %9d x %-9d %4d workers %9.3f s  speedup %6.2f  efficiency %5.2f" %
+                      (engine, args.mode, height, width, workers, seconds, speedup, efficiency))
+    return rows
+
+
+def plot(args, rows):
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print("matplotlib not found, skipping the plot", file=sys.stderr)
+        return
+    figure, axis = plt.subplots()
+    curves = {}
+    for row in rows:
+        if args.mode == "strong":
+            label = "%s %dx%d" % (row["engine"], row["height"], row["width"])
+        else:
+            label = "%s from %d" % (row["engine"], row["size"])
+        workers, efficiency = curves.setdefault(label, ([], []))
+        workers.append(row["workers"])
+        efficiency.append(float(row["efficiency"]))
+    for label, (workers, efficiency) in curves.items():
+        axis.plot(workers, efficiency, marker="o", label=label)
+    axis.axhline(1.0, color="grey", linewidth=0.5)
+    axis.set_xscale("log", base=2)
+    axis.set_xlabel("threads / ranks")
+    axis.set_ylabel("%s scaling efficiency" % args.mode)
+    axis.legend()
+    figure.savefig(os.path.join(args.out, "efficiency.png"), dpi=120)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--bin", default=".", help="directory with lcs-generate, lcs-omp and lcs-mpi")
+    parser.add_argument("--out", default="scaling", help="directory for inputs, scaling.csv and efficiency.png")
+    parser.add_argument("--mode", choices=["strong", "weak"], default="strong")
+    parser.add_argument("--sizes", type=int, nargs="+", default=[8000], help="height, at one worker for weak scaling")
+    parser.add_argument("--ratio", type=float, default=1.0, help="width / height")
+    parser.add_argument("--alphabet", type=int, default=4)
+    parser.add_argument("--mutation", type=float, default=0.1)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--threads", type=int, nargs="*", default=[1, 2, 4], help="lcs-omp thread counts, none to skip")
+    parser.add_argument("--ranks", type=int, nargs="*", default=[], help="lcs-mpi rank counts")
+    parser.add_argument("--mpirun", default="mpirun")
+    parser.add_argument("--repeat", type=int, default=3)
+    args = parser.parse_args()
+
+    os.makedirs(args.out, exist_ok=True)
+    rows = sweep(args)
+    with open(os.path.join(args.out, "scaling.csv"), "w", newline="") as file:
+        writer = csv.DictWriter(file, fieldnames=["engine", "mode", "size", "height", "width", "workers", "seconds",
+                                                  "speedup", "efficiency", "length"])
+        writer.writeheader()
+        writer.writerows(rows)
+    plot(args, rows)
+
+
+if __name__ == "__main__":
+    main()
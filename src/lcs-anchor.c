@@ -0,0 +1,633 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+#define MAX(x, y) ( ((x) > (y)) ? (x) : (y) )
+#define MIN(x, y) ( ((x) > (y)) ? (y) : (x) )
+
+#define K 16			//k-mer length of the seeds
+#define MAX_OCCURRENCES 8	//k-mers more frequent than this in vectorWidth are repeats, not seeds
+#define HASH_BASE 0x100000001B3ULL
+
+#define DIAGONAL 0
+#define LEFT 1
+#define UP 2
+
+/* An exact match H[i..i+length-1] == W[j..j+length-1], maximal on both sides
+ */
+typedef struct {
+	int i;
+	int j;
+	int length;
+	long weight;	//sum of the costs of its cells
+	long best;	//best chain ending with it
+	int previous;	//anchor before it in that chain, -1 for none
+}anchor_t;
+
+/* Index of every k-mer of vectorWidth: positions grouped by hash bucket
+ */
+typedef struct {
+	uint64_t mask;
+	int* start;		//mask + 2 offsets into positions
+	int* positions;
+}index_t;
+
+typedef struct {
+	int height;
+	int width;
+	char* vectorHeight;
+	char* vectorWidth;
+	short* costTable;
+	short maxCost;
+	short unitCost;		//1 when every cost(i + j) is 1, the bounded fill needs it
+	int k;
+	anchor_t* anchors;
+	int numAnchors;
+	int* chain;		//anchors of the backbone, in order
+	int chainLength;
+	long anchoredCells;	//cells on the backbone
+	long gapCells;		//cells filled by the gap DP
+	short* rows;		//two rows for the gap DP
+	unsigned char* directions;	//2 bits per cell of the current gap
+	size_t directionsCapacity;
+	char* subsequence;
+	int size;		//characters found
+	long value;		//sum of their costs
+}board_t;
+
+typedef board_t* Board;
+
+short cost(int x);
+Board parseFile(char* fileName, int k);
+uint64_t hashKmer(char* vector, int k);
+void buildIndex(index_t* index, Board board);
+void findAnchors(index_t* index, Board board);
+int compareAnchors(const void* a, const void* b);
+int compareKeys(const void* a, const void* b);
+void chainAnchors(Board board);
+void solveGap(int i0, int i1, int j0, int j1, Board board);
+long upperBound(Board board);
+long boundedFill(Board board, long* value);
+void printResults(board_t* board);
+void cleanAll(board_t* board);
+
+int main(int argc, char* argv[]){
+
+	int k = K, exact = 0, n, a, i, j;
+	char* fileName = NULL;
+	index_t index;
+	long bound, value, cells;
+	anchor_t* anchor;
+
+	for(n = 1; n < argc; n++){
+		if(!strcmp(argv[n], "-x")) exact = 1;
+		else if(fileName == NULL) fileName = argv[n];
+		else k = atoi(argv[n]);
+	}
+	if(fileName == NULL || k < 1){
+		printf("Usage: %s file.in [k] [-x]\n", argv[0]);
+		exit(1);
+	}
+	Board board = parseFile(fileName, k);
+
+	buildIndex(&index, board);
+	findAnchors(&index, board);
+	free(index.start);
+	free(index.positions);
+	chainAnchors(board);
+
+	/* DP in the gap before each anchor, the anchor itself, and the last gap */
+	i = 1;
+	j = 1;
+	for(n = 0; n < board->chainLength; n++){
+		anchor = &board->anchors[board->chain[n]];
+		solveGap(i, anchor->i - 1, j, anchor->j - 1, board);
+		for(a = 0; a < anchor->length; a++){
+			board->subsequence[board->size++] = board->vectorHeight[anchor->i + a];
+		}
+		board->value += anchor->weight;
+		board->anchoredCells += anchor->length;
+		i = anchor->i + anchor->length;
+		j = anchor->j + anchor->length;
+	}
+	solveGap(i, board->height, j, board->width, board);
+
+	bound = upperBound(board);
+	fprintf(stderr, "anchor: %d anchors, backbone of %d covering %ld characters, gaps %ld cells (%.2f%% of the matrix)\n",
+	        board->numAnchors, board->chainLength, board->anchoredCells, board->gapCells,
+	        100.0 * board->gapCells / MAX(1.0, (double)board->height * board->width));
+	if(board->chainLength == 0){
+		fprintf(stderr, "anchor: no anchors, the gap was the full matrix\n");
+	}else if(board->value == bound){
+		fprintf(stderr, "anchor: optimal, %ld reaches the upper bound\n", board->value);
+	}else if(!exact){
+		fprintf(stderr, "anchor: not proven optimal, %ld of at most %ld, -x checks it\n", board->value, bound);
+	}else if(!board->unitCost){
+		/* a match always takes the diagonal in the recurrence, with weighted
+		 * costs that is not the best path and the bound does not hold */
+		value = board->value;
+		board->size = 0;
+		board->value = 0;
+		board->gapCells = 0;
+		solveGap(1, board->height, 1, board->width, board);
+		fprintf(stderr, "anchor: weighted costs, the full DP gives %ld (the backbone %ld)\n", board->value, value);
+	}else{
+		value = board->value;
+		cells = boundedFill(board, &value);
+		if(value == board->value){
+			fprintf(stderr, "anchor: optimal, nothing beats %ld in the %ld cells that could (%.2f%% of the matrix)\n",
+			        value, cells, 100.0 * cells / MAX(1.0, (double)board->height * board->width));
+		}else{
+			fprintf(stderr, "anchor: the backbone gives %ld, the optimum is %ld, found in %ld cells (%.2f%% of the matrix)\n",
+			        board->value, value, cells, 100.0 * cells / MAX(1.0, (double)board->height * board->width));
+			board->value = value;
+		}
+	}
+	printResults(board);
+	cleanAll(board);
+	return 0;
+}
+
+/* Polynomial hash of the k characters from vector
+ */
+uint64_t hashKmer(char* vector, int k){
+	uint64_t hash = 0;
+	int n;
+
+	for(n = 0; n < k; n++){
+		hash = hash * HASH_BASE + (unsigned char)vector[n];
+	}
+	return hash;
+}
+
+/* Function that indexes every k-mer of vectorWidth
+ * The hash rolls along the sequence, positions are counted per bucket,
+ * then stored grouped by bucket, in increasing order inside each one
+ */
+void buildIndex(index_t* index, Board board){
+	int kmers = MAX(board->width - board->k + 1, 0);
+	uint64_t buckets = 1, top = 1, hash = 0;
+	int j, n;
+
+	while(buckets < 2 * (uint64_t)kmers) buckets <<= 1;
+	index->mask = buckets - 1;
+	index->start = (int*)calloc(buckets + 1, sizeof(int));
+	index->positions = (int*)malloc(sizeof(int) * MAX(kmers, 1));
+	if(index->start == NULL || index->positions == NULL){
+		printf("Error allocating the k-mer index.\n");
+		exit(4);
+	}
+	for(n = 1; n < board->k; n++) top *= HASH_BASE;
+
+	for(j = 1; j <= kmers; j++){
+		hash = (j == 1) ? hashKmer(board->vectorWidth + 1, board->k)
+		     : (hash - top * (unsigned char)board->vectorWidth[j - 1]) * HASH_BASE
+		       + (unsigned char)board->vectorWidth[j + board->k - 1];
+		index->start[(hash & index->mask) + 1]++;
+	}
+	for(n = 0; n < buckets; n++) index->start[n + 1] += index->start[n];
+	for(j = 1; j <= kmers; j++){
+		hash = (j == 1) ? hashKmer(board->vectorWidth + 1, board->k)
+		     : (hash - top * (unsigned char)board->vectorWidth[j - 1]) * HASH_BASE
+		       + (unsigned char)board->vectorWidth[j + board->k - 1];
+		index->positions[index->start[hash & index->mask]++] = j;
+	}
+	for(n = buckets; n > 0; n--) index->start[n] = index->start[n - 1];
+	index->start[0] = 0;
+}
+
+/* Function that finds the anchors
+ * Every k-mer of vectorHeight is looked up; a hit that can be extended
+ * to the left is the middle of another match and is skipped, the others
+ * are extended to the right as far as they go
+ * Repeated k-mers would flood the chain with unrelated hits and are skipped
+ */
+void findAnchors(index_t* index, Board board){
+	int capacity = 1024, kmers = MAX(board->height - board->k + 1, 0);
+	uint64_t top = 1, hash = 0, bucket;
+	int i, j, n, found, length;
+	anchor_t* anchor;
+
+	board->anchors = (anchor_t*)malloc(sizeof(anchor_t) * capacity);
+	board->numAnchors = 0;
+	for(n = 1; n < board->k; n++) top *= HASH_BASE;
+
+	for(i = 1; i <= kmers; i++){
+		hash = (i == 1) ? hashKmer(board->vectorHeight + 1, board->k)
+		     : (hash - top * (unsigned char)board->vectorHeight[i - 1]) * HASH_BASE
+		       + (unsigned char)board->vectorHeight[i + board->k - 1];
+		bucket = hash & index->mask;
+		found = 0;
+		for(n = index->start[bucket]; n < index->start[bucket + 1] && found <= MAX_OCCURRENCES; n++){
+			if(!memcmp(board->vectorHeight + i, board->vectorWidth + index->positions[n], board->k)) found++;
+		}
+		if(found == 0 || found > MAX_OCCURRENCES) continue;
+
+		for(n = index->start[bucket]; n < index->start[bucket + 1]; n++){
+			j = index->positions[n];
+			if(memcmp(board->vectorHeight + i, board->vectorWidth + j, board->k)) continue;
+			if(i > 1 && j > 1 && board->vectorHeight[i - 1] == board->vectorWidth[j - 1]) continue;
+			length = board->k;
+			while(i + length <= board->height && j + length <= board->width &&
+			      board->vectorHeight[i + length] == board->vectorWidth[j + length]) length++;
+			if(board->numAnchors == capacity){
+				capacity *= 2;
+				board->anchors = (anchor_t*)realloc(board->anchors, sizeof(anchor_t) * capacity);
+			}
+			anchor = &board->anchors[board->numAnchors++];
+			anchor->i = i;
+			anchor->j = j;
+			anchor->length = length;
+			anchor->weight = 0;
+			for(found = 0; found < length; found++){
+				anchor->weight += board->costTable[i + j + 2 * found];
+			}
+		}
+	}
+}
+
+int compareAnchors(const void* a, const void* b){
+	const anchor_t* x = (const anchor_t*)a;
+	const anchor_t* y = (const anchor_t*)b;
+
+	if(x->i != y->i) return (x->i > y->i) - (x->i < y->i);
+	return (x->j > y->j) - (x->j < y->j);
+}
+
+int compareKeys(const void* a, const void* b){
+	long long x = *(const long long*)a, y = *(const long long*)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Function that chains the anchors into the co-linear backbone
+ * An anchor can follow another one that ends above and left of its start;
+ * the chain of largest weight is found in O(n log n): anchors are taken
+ * by start row, those that end above it are moved into a Fenwick tree of
+ * the best chain ending at each column, and a prefix max gives the best
+ * predecessor
+ */
+void chainAnchors(Board board){
+	int numAnchors = board->numAnchors;
+	int* byEnd = (int*)malloc(sizeof(int) * MAX(numAnchors, 1));
+	int* tree = (int*)malloc(sizeof(int) * (board->width + 2));
+	long long* ends = (long long*)malloc(sizeof(long long) * MAX(numAnchors, 1));
+	int n, e = 0, a, column, best = -1;
+	anchor_t* anchors;
+
+	qsort(board->anchors, numAnchors, sizeof(anchor_t), compareAnchors);
+	anchors = board->anchors;
+	/* sorted by end row through keys holding the row above the index */
+	for(n = 0; n < numAnchors; n++){
+		ends[n] = ((long long)(anchors[n].i + anchors[n].length) << 32) | n;
+	}
+	qsort(ends, numAnchors, sizeof(long long), compareKeys);
+	for(n = 0; n < numAnchors; n++) byEnd[n] = (int)(ends[n] & 0xFFFFFFFF);
+	free(ends);
+	for(column = 0; column <= board->width + 1; column++) tree[column] = -1;
+
+	for(n = 0; n < numAnchors; n++){
+		while(e < numAnchors && anchors[byEnd[e]].i + anchors[byEnd[e]].length <= anchors[n].i){
+			a = byEnd[e++];
+			for(column = anchors[a].j + anchors[a].length - 1; column <= board->width; column += column & -column){
+				if(tree[column] < 0 || anchors[tree[column]].best < anchors[a].best) tree[column] = a;
+			}
+		}
+		anchors[n].previous = -1;
+		for(column = anchors[n].j - 1; column > 0; column -= column & -column){
+			if(tree[column] >= 0 && (anchors[n].previous < 0 || anchors[tree[column]].best > anchors[anchors[n].previous].best)){
+				anchors[n].previous = tree[column];
+			}
+		}
+		anchors[n].best = anchors[n].weight + (anchors[n].previous < 0 ? 0 : anchors[anchors[n].previous].best);
+		if(best < 0 || anchors[n].best > anchors[best].best) best = n;
+	}
+
+	board->chainLength = 0;
+	for(a = best; a >= 0; a = anchors[a].previous) board->chainLength++;
+	board->chain = (int*)malloc(sizeof(int) * MAX(board->chainLength, 1));
+	n = board->chainLength;
+	for(a = best; a >= 0; a = anchors[a].previous) board->chain[--n] = a;
+	free(byEnd);
+	free(tree);
+}
+
+/* Function that solves the gap [i0,i1] x [j0,j1] with the LCS recurrence
+ * Two rows and the 2-bit moves of lcs-serial, then its backtrack; the
+ * characters are appended to the subsequence
+ */
+void solveGap(int i0, int i1, int j0, int j1, Board board){
+	int height = i1 - i0 + 1, width = j1 - j0 + 1;
+	size_t columns = (size_t)width + 1, cells, cell;
+	short *previous, *current, *aux, value;
+	int i, j, direction, found, first;
+
+	if(height <= 0 || width <= 0) return;
+	cells = ((size_t)height + 1) * columns;
+	board->gapCells += (long)height * width;
+	if((cells + 3) / 4 > board->directionsCapacity){
+		free(board->directions);
+		board->directionsCapacity = (cells + 3) / 4;
+		if(!(board->directions = (unsigned char*)malloc(board->directionsCapacity))){
+			printf("Error allocating directions for board.\n");
+			exit(4);
+		}
+	}
+	memset(board->directions, 0, (cells + 3) / 4);
+	previous = board->rows;
+	current = board->rows + board->width + 1;
+	memset(previous, 0, sizeof(short) * columns);
+
+	for(i = 1; i <= height; i++){
+		current[0] = 0;
+		for(j = 1; j <= width; j++){
+			if(board->vectorHeight[i0 + i - 1] == board->vectorWidth[j0 + j - 1]){
+				value = previous[j - 1] + board->costTable[i0 + j0 + i + j - 2];
+			}else{
+				value = MAX(previous[j], current[j - 1]);
+			}
+			current[j] = value;
+			if((previous[j] != value) && (current[j - 1] != value)){
+				direction = DIAGONAL;
+			}else if(board->vectorHeight[i0 + i - 1] == board->vectorWidth[j0 + j - 1]){
+				direction = DIAGONAL;
+			}else if(current[j - 1] == value){
+				direction = LEFT;
+			}else{
+				direction = UP;
+			}
+			cell = (size_t)i * columns + j;
+			board->directions[cell / 4] |= direction << (2 * (cell % 4));
+		}
+		aux = previous;
+		previous = current;
+		current = aux;
+	}
+
+	/* the characters come out backwards, they are reversed in place */
+	first = board->size;
+	found = previous[width];
+	board->value += found;
+	i = height;
+	j = width;
+	while(found > 0){
+		cell = (size_t)i * columns + j;
+		switch((board->directions[cell / 4] >> (2 * (cell % 4))) & 3){
+			case DIAGONAL:
+				board->subsequence[board->size++] = board->vectorHeight[i0 + i - 1];
+				found -= board->costTable[i0 + j0 + i + j - 2];
+				i--;
+				j--;
+				break;
+			case LEFT:
+				j--;
+				break;
+			default:
+				i--;
+		}
+	}
+	for(i = first, j = board->size - 1; i < j; i++, j--){
+		value = board->subsequence[i];
+		board->subsequence[i] = board->subsequence[j];
+		board->subsequence[j] = value;
+	}
+}
+
+/* Upper bound from the character counts, as in lcs-estimate
+ * returns the bound
+ */
+long upperBound(Board board){
+	long countHeight[256] = {0}, countWidth[256] = {0};
+	long matches = 0;
+	int n;
+
+	for(n = 1; n <= board->height; n++) countHeight[(unsigned char)board->vectorHeight[n]]++;
+	for(n = 1; n <= board->width; n++) countWidth[(unsigned char)board->vectorWidth[n]]++;
+	for(n = 0; n < 256; n++) matches += MIN(countHeight[n], countWidth[n]);
+	return matches * board->maxCost;
+}
+
+/* Function that checks the backbone with the LCS recurrence, only on the
+ * cells where it can be beaten
+ * A cell is dropped when its best prefix plus the most its suffix can add,
+ * min(h - i, w - j) * maxCost, is not above the backbone value; a better
+ * path only goes through kept cells, so the kept cells give it exactly.
+ * Around the anchors a wrong turn falls behind at once, so what is left is
+ * a band along the backbone, wider where the gaps are
+ * Only for unit costs, where the recurrence is the best path
+ * Each row keeps the 2-bit moves between its first and last kept cell
+ * value, the backbone value, replaced by the optimum when a path beats it
+ * returns the cells filled
+ */
+long boundedFill(Board board, long* value){
+	int height = board->height, width = board->width;
+	int* previous = (int*)malloc(sizeof(int) * (width + 1));
+	int* current = (int*)malloc(sizeof(int) * (width + 1));
+	int* first = (int*)malloc(sizeof(int) * (height + 1));
+	int* last = (int*)malloc(sizeof(int) * (height + 1));
+	size_t* offset = (size_t*)malloc(sizeof(size_t) * (height + 2));
+	unsigned char* moves = (unsigned char*)malloc(width + 1);
+	int *aux, i, j, up, left, diag, best, match, found, start;
+	char letter;
+	long cells = 0, limit = *value;
+	size_t cell;
+
+	if(!previous || !current || !first || !last || !offset || !moves){
+		printf("Error allocating row pointers for board.\n");
+		exit(4);
+	}
+	/* row 0, every prefix is 0 */
+	first[0] = 0;
+	last[0] = -1;
+	for(j = 0; j <= width && (long)MIN(height, width - j) * board->maxCost > limit; j++){
+		previous[j] = 0;
+		last[0] = j;
+	}
+	offset[0] = 0;
+	offset[1] = last[0] + 1;
+	board->directionsCapacity = 0;
+
+	for(i = 1; i <= height && last[i - 1] >= first[i - 1]; i++){
+		first[i] = -1;
+		last[i] = -1;
+		start = first[i - 1];
+		for(j = start; j <= width; j++){
+			up = (j <= last[i - 1]) ? previous[j] : -1;
+			diag = (j > start && j - 1 <= last[i - 1]) ? previous[j - 1] : -1;
+			left = (j > start) ? current[j - 1] : -1;
+			if(j > last[i - 1] + 1 && left < 0) break;
+			match = (j > 0 && diag >= 0 && board->vectorHeight[i] == board->vectorWidth[j]);
+			best = MAX(up, left);
+			if(match) best = MAX(best, diag + board->costTable[i + j]);
+			if(best >= 0 && best + (long)MIN(height - i, width - j) * board->maxCost <= limit) best = -1;
+			current[j] = best;
+			if(best < 0) continue;
+			if(first[i] < 0) first[i] = j;
+			last[i] = j;
+			if(match && diag + board->costTable[i + j] == best) moves[j] = DIAGONAL;
+			else if(left == best) moves[j] = LEFT;
+			else moves[j] = UP;
+		}
+		if(first[i] < 0) break;
+		cells += last[i] - first[i] + 1;
+
+		/* the moves of the kept interval are appended to the directions */
+		offset[i + 1] = offset[i] + (last[i] - first[i] + 1);
+		if((offset[i + 1] + 3) / 4 > board->directionsCapacity){
+			board->directionsCapacity = MAX((offset[i + 1] + 3) / 4, 2 * board->directionsCapacity);
+			board->directions = (unsigned char*)realloc(board->directions, board->directionsCapacity);
+			if(board->directions == NULL){
+				printf("Error allocating directions for board.\n");
+				exit(4);
+			}
+		}
+		for(j = first[i]; j <= last[i]; j++){
+			cell = offset[i] + (j - first[i]);
+			/* the buffer still holds the moves of the gaps, row 1 does not start on a byte */
+			board->directions[cell / 4] &= ~(3 << (2 * (cell % 4)));
+			board->directions[cell / 4] |= ((current[j] < 0) ? UP : moves[j]) << (2 * (cell % 4));
+		}
+		aux = previous;
+		previous = current;
+		current = aux;
+	}
+
+	/* a path above the backbone reached the corner, its backtrack replaces the result */
+	if(i > height && last[height] == width){
+		*value = previous[width];
+		board->size = 0;
+		found = previous[width];
+		i = height;
+		j = width;
+		while(found > 0){
+			cell = offset[i] + (j - first[i]);
+			switch((board->directions[cell / 4] >> (2 * (cell % 4))) & 3){
+				case DIAGONAL:
+					board->subsequence[board->size++] = board->vectorHeight[i];
+					found -= board->costTable[i + j];
+					i--;
+					j--;
+					break;
+				case LEFT:
+					j--;
+					break;
+				default:
+					i--;
+			}
+		}
+		for(i = 0, j = board->size - 1; i < j; i++, j--){
+			letter = board->subsequence[i];
+			board->subsequence[i] = board->subsequence[j];
+			board->subsequence[j] = letter;
+		}
+	}
+	free(previous);
+	free(current);
+	free(first);
+	free(last);
+	free(offset);
+	free(moves);
+	return cells;
+}
+
+/* Function that reads the file and builds the board
+ * Builds the vertical and horizontal string and the cost table
+ * filename, the name of the file to be read; k, the seed length
+ * returns the board
+ */
+Board parseFile(char* fileName, int k){
+	FILE* file;
+	int height;
+	int width;
+	int c;
+	char* vectorHeight;
+	char* vectorWeidth;
+	size_t n = 1;
+
+	if (!(file = fopen(fileName,"r"))){
+	    printf("Error opening file \"%s\"\n", fileName);
+	    exit(2);
+	}
+	if(fscanf(file, "%d %d\n", &height, &width) == 0){
+	    printf("Could not read height and width");
+	    exit(3);
+	}
+	if(!(vectorHeight = (char*) malloc(sizeof(char)*(height + 1)))||
+	   !(vectorWeidth = (char*) malloc(sizeof(char)*(width + 1)))){
+		    printf("Error allocating row pointers for board.\n");
+		    exit(4);
+	}
+
+	while((c = fgetc(file)) != '\n' && c != EOF){
+		 vectorHeight[n++] = (char)c;
+	}
+	vectorHeight[0] = '/';
+
+	n = 1;
+	while((c = fgetc(file)) != '\n' && c != EOF){
+		vectorWeidth[n++] = (char)c;
+	}
+	vectorWeidth[0] = '/';
+	fclose(file);
+	file = NULL;
+
+	Board result = (Board)calloc(1, sizeof(board_t));
+
+	result->height = height;
+	result->width = width;
+	result->vectorHeight = vectorHeight;
+	result->vectorWidth = vectorWeidth;
+	result->k = k;
+	result->unitCost = 1;
+	result->costTable = (short*)malloc(sizeof(short) * (height + width + 1));
+	for(n = 0; n < height + width + 1; n++){
+		result->costTable[n] = cost(n);
+		if(n >= 2) result->maxCost = MAX(result->maxCost, result->costTable[n]);
+		if(n >= 2 && result->costTable[n] != 1) result->unitCost = 0;
+	}
+	result->rows = (short*)malloc(sizeof(short) * 2 * (width + 1));
+	result->subsequence = (char*)malloc(sizeof(char) * (MIN(height, width) + 1));
+
+	return result;
+}
+
+/* Prints the result of the LCS and the subsequence
+ */
+void printResults(board_t* board){
+	int n;
+
+	printf("%ld\n", board->value);
+	for (n = 0; n < board->size; ++n) {
+		printf("%c", board->subsequence[n]);
+	}
+	printf("\n");
+}
+
+/* Function to add computation time
+ * returns 1 always
+ */
+short cost(int x){
+	int i, n_iter = 20;
+	double dcost = 0;
+	for(i = 0; i < n_iter; i++)
+		dcost += pow(sin((double) x),2) + pow(cos((double) x),2);
+	return (short) (dcost / n_iter + 0.1);
+}
+
+/*
+ * Clears the resourses used
+ */
+void cleanAll(board_t* board){
+
+	free(board->vectorHeight);
+	free(board->vectorWidth);
+	free(board->costTable);
+	free(board->anchors);
+	free(board->chain);
+	free(board->rows);
+	free(board->directions);
+	free(board->subsequence);
+	free(board);
+}
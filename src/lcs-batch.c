@@ -0,0 +1,539 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <omp.h>
+
+#define MAX(x, y) ( ((x) > (y)) ? (x) : (y) )
+#define MIN(x, y) ( ((x) > (y)) ? (y) : (x) )
+
+#define QUEUE_DEPTH 4		//parsed pairs waiting for a worker, and results waiting for the writer
+#define OUTPUT_BUFFER (1 << 20)
+
+#define DIAGONAL 0
+#define LEFT 1
+#define UP 2
+
+/* One pair on its way through the pipeline
+ * Jobs are recycled: every buffer only grows, so after the first few pairs
+ * the stages run without allocating
+ * Only what travels between the stages lives here, the board is in the
+ * scratch of the worker that solves it
+ */
+typedef struct job {
+	long index;		//position in the input list, the writer keeps this order
+	char* fileName;
+	int height;
+	int width;
+	char* vectorHeight;
+	char* vectorWidth;
+	size_t heightCapacity;
+	size_t widthCapacity;
+	short* costTable;	//cost(i + j)
+	size_t costCapacity;
+	int failed;		//the file could not be read, nothing is printed for it
+	char* subsequence;
+	size_t subsequenceCapacity;
+	int finalSize;
+	struct job* next;
+}job_t;
+
+typedef job_t* Job;
+
+/* Board of one worker, reused for every pair it solves
+ */
+typedef struct {
+	short* rows;		//two rows of width + 1
+	size_t rowsCapacity;
+	unsigned char* directions;	//4 cells per byte, row major, as in lcs-serial
+	size_t directionsCapacity;
+}scratch_t;
+
+typedef scratch_t* Scratch;
+
+/* Bounded FIFO between two stages, closed by the producer when it is done
+ */
+typedef struct {
+	Job head;
+	Job tail;
+	int count;
+	int closed;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+}queue_t;
+
+typedef struct {
+	char** fileNames;
+	long numFiles;
+	int workers;
+	queue_t free;		//recycled jobs
+	queue_t parsed;		//read, waiting for a worker
+	queue_t done;		//solved, waiting for the writer
+	int running;		//workers still taking jobs
+	pthread_mutex_t runningLock;
+	double readSeconds;
+	double* computeSeconds;	//one per worker
+	double writeSeconds;
+	size_t bytesWritten;
+	long failedFiles;	//only the reader writes it
+}pipeline_t;
+
+typedef pipeline_t* Pipeline;
+
+typedef struct {
+	Pipeline pipeline;
+	int worker;
+}worker_arg_t;
+
+short cost(int x);
+char** readFileList(int argc, char* argv[], long* numFiles);
+void initQueue(queue_t* queue);
+void push(queue_t* queue, Job job);
+Job pop(queue_t* queue);
+void closeQueue(queue_t* queue);
+void* grow(void* buffer, size_t* capacity, size_t needed);
+int parseFile(Job job);
+void iterateBoard(Job job, Scratch scratch);
+void backtrack(Job job, Scratch scratch);
+void* readStage(void* arg);
+void* computeStage(void* arg);
+void* writeStage(void* arg);
+void writeResult(Job job, char* buffer, size_t* used, Pipeline pipeline);
+void flushOutput(char* buffer, size_t* used, Pipeline pipeline);
+void cleanAll(Pipeline pipeline);
+
+int main(int argc, char* argv[]){
+
+	pipeline_t pipeline;
+	pthread_t reader, writer;
+	pthread_t* computers;
+	worker_arg_t* args;
+	char* workers = getenv("LCS_WORKERS");
+	double start = omp_get_wtime(), compute = 0;
+	Job job;
+	int n;
+
+	if(argc < 2){
+		printf("Usage: %s file.in... | -\n", argv[0]);
+		exit(1);
+	}
+	pipeline.fileNames = readFileList(argc, argv, &pipeline.numFiles);
+	pipeline.workers = (workers && atoi(workers) > 0) ? atoi(workers) : MAX(1, (int)sysconf(_SC_NPROCESSORS_ONLN) - 2);
+	initQueue(&pipeline.free);
+	initQueue(&pipeline.parsed);
+	initQueue(&pipeline.done);
+	pipeline.running = pipeline.workers;
+	pthread_mutex_init(&pipeline.runningLock, NULL);
+	pipeline.readSeconds = pipeline.writeSeconds = 0;
+	pipeline.bytesWritten = 0;
+	pipeline.failedFiles = 0;
+	pipeline.computeSeconds = (double*)calloc(pipeline.workers, sizeof(double));
+
+	/* every job in flight is either queued or owned by one stage: a pair
+	 * being read, QUEUE_DEPTH parsed, one per worker, QUEUE_DEPTH solved and
+	 * one being written. Jobs only hold the sequences and the result, the
+	 * boards are one per worker */
+	for(n = 0; n < pipeline.workers + 2 * QUEUE_DEPTH + 2; n++){
+		job = (Job)calloc(1, sizeof(job_t));
+		push(&pipeline.free, job);
+	}
+
+	computers = (pthread_t*)malloc(sizeof(pthread_t) * pipeline.workers);
+	args = (worker_arg_t*)malloc(sizeof(worker_arg_t) * pipeline.workers);
+	pthread_create(&reader, NULL, readStage, &pipeline);
+	for(n = 0; n < pipeline.workers; n++){
+		args[n].pipeline = &pipeline;
+		args[n].worker = n;
+		pthread_create(&computers[n], NULL, computeStage, &args[n]);
+	}
+	pthread_create(&writer, NULL, writeStage, &pipeline);
+
+	pthread_join(reader, NULL);
+	for(n = 0; n < pipeline.workers; n++){
+		pthread_join(computers[n], NULL);
+		compute += pipeline.computeSeconds[n];
+	}
+	pthread_join(writer, NULL);
+
+	fprintf(stderr, "batch: %ld pairs in %.3f s, read %.3f s, compute %.3f s on %d workers, write %.3f s (%zu bytes)\n",
+	        pipeline.numFiles, omp_get_wtime() - start, pipeline.readSeconds, compute, pipeline.workers,
+	        pipeline.writeSeconds, pipeline.bytesWritten);
+	free(computers);
+	free(args);
+	if(pipeline.failedFiles > 0){
+		fprintf(stderr, "batch: %ld of %ld files could not be read\n", pipeline.failedFiles, pipeline.numFiles);
+	}
+	cleanAll(&pipeline);
+	return (pipeline.failedFiles > 0) ? 2 : 0;
+}
+
+/* Function that builds the list of inputs
+ * The arguments are the files, or "-" to read one name per line from stdin
+ * returns the names, numFiles is set to their count
+ */
+char** readFileList(int argc, char* argv[], long* numFiles){
+	char** names;
+	char line[4096];
+	long capacity = 64, n;
+
+	if(argc == 2 && !strcmp(argv[1], "-")){
+		names = (char**)malloc(sizeof(char*) * capacity);
+		*numFiles = 0;
+		while(fgets(line, sizeof(line), stdin)){
+			line[strcspn(line, "\r\n")] = '\0';
+			if(line[0] == '\0') continue;
+			if(*numFiles == capacity){
+				capacity *= 2;
+				names = (char**)realloc(names, sizeof(char*) * capacity);
+			}
+			names[(*numFiles)++] = strdup(line);
+		}
+		return names;
+	}
+	*numFiles = argc - 1;
+	names = (char**)malloc(sizeof(char*) * *numFiles);
+	for(n = 0; n < *numFiles; n++){
+		names[n] = strdup(argv[n + 1]);
+	}
+	return names;
+}
+
+void initQueue(queue_t* queue){
+	queue->head = queue->tail = NULL;
+	queue->count = 0;
+	queue->closed = 0;
+	pthread_mutex_init(&queue->lock, NULL);
+	pthread_cond_init(&queue->changed, NULL);
+}
+
+/* Appends a job, the queues are bounded by the number of jobs in flight
+ */
+void push(queue_t* queue, Job job){
+	pthread_mutex_lock(&queue->lock);
+	job->next = NULL;
+	if(queue->tail) queue->tail->next = job;
+	else queue->head = job;
+	queue->tail = job;
+	queue->count++;
+	pthread_cond_broadcast(&queue->changed);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+/* Takes the oldest job, waiting for one
+ * returns NULL once the queue is closed and empty
+ */
+Job pop(queue_t* queue){
+	Job job;
+
+	pthread_mutex_lock(&queue->lock);
+	while(queue->head == NULL && !queue->closed){
+		pthread_cond_wait(&queue->changed, &queue->lock);
+	}
+	job = queue->head;
+	if(job){
+		queue->head = job->next;
+		if(queue->head == NULL) queue->tail = NULL;
+		queue->count--;
+	}
+	pthread_mutex_unlock(&queue->lock);
+	return job;
+}
+
+void closeQueue(queue_t* queue){
+	pthread_mutex_lock(&queue->lock);
+	queue->closed = 1;
+	pthread_cond_broadcast(&queue->changed);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+/* Makes a recycled buffer hold at least needed bytes, it never shrinks
+ * returns the buffer
+ */
+void* grow(void* buffer, size_t* capacity, size_t needed){
+	if(needed <= *capacity) return buffer;
+	free(buffer);
+	if(!(buffer = malloc(needed))){
+		fprintf(stderr, "Error allocating row pointers for board.\n");
+		exit(4);
+	}
+	*capacity = needed;
+	return buffer;
+}
+
+/* Reader thread, parses the inputs in order into recycled jobs
+ * Waits for a free job, so it never runs more than the pipeline holds ahead
+ * A file that cannot be read still goes down the pipeline, marked failed,
+ * so the writer keeps the order of the others and skips it
+ */
+void* readStage(void* arg){
+	Pipeline pipeline = (Pipeline)arg;
+	double start;
+	Job job;
+	long n;
+
+	for(n = 0; n < pipeline->numFiles; n++){
+		job = pop(&pipeline->free);
+		start = omp_get_wtime();
+		job->index = n;
+		job->fileName = pipeline->fileNames[n];
+		job->failed = !parseFile(job);
+		if(job->failed) pipeline->failedFiles++;
+		pipeline->readSeconds += omp_get_wtime() - start;
+		push(&pipeline->parsed, job);
+	}
+	closeQueue(&pipeline->parsed);
+	return NULL;
+}
+
+/* Compute thread, solves parsed pairs until the reader is done
+ * The board is kept by the worker, so it takes one per worker at the size
+ * of the largest pair it met, not one per job in flight
+ * The last worker out closes the queue of the writer
+ */
+void* computeStage(void* arg){
+	Pipeline pipeline = ((worker_arg_t*)arg)->pipeline;
+	int worker = ((worker_arg_t*)arg)->worker;
+	scratch_t scratch = {NULL, 0, NULL, 0};
+	double start;
+	Job job;
+
+	while((job = pop(&pipeline->parsed)) != NULL){
+		if(!job->failed){
+			start = omp_get_wtime();
+			iterateBoard(job, &scratch);
+			backtrack(job, &scratch);
+			pipeline->computeSeconds[worker] += omp_get_wtime() - start;
+		}
+		push(&pipeline->done, job);
+	}
+	free(scratch.rows);
+	free(scratch.directions);
+	pthread_mutex_lock(&pipeline->runningLock);
+	if(--pipeline->running == 0) closeQueue(&pipeline->done);
+	pthread_mutex_unlock(&pipeline->runningLock);
+	return NULL;
+}
+
+/* Writer thread, prints the results in input order through one buffer
+ * Results that finish early wait in a small list until their turn
+ */
+void* writeStage(void* arg){
+	Pipeline pipeline = (Pipeline)arg;
+	char* buffer = (char*)malloc(OUTPUT_BUFFER);
+	size_t used = 0;
+	long next = 0;
+	int idle;
+	Job waiting = NULL, job, *link;
+	double start;
+
+	while((job = pop(&pipeline->done)) != NULL){
+		job->next = waiting;
+		waiting = job;
+		start = omp_get_wtime();
+		for(link = &waiting; *link != NULL; ){
+			if((*link)->index != next){
+				link = &(*link)->next;
+				continue;
+			}
+			job = *link;
+			*link = job->next;
+			if(!job->failed) writeResult(job, buffer, &used, pipeline);
+			push(&pipeline->free, job);
+			next++;
+			link = &waiting;
+		}
+		/* nothing else can be printed before a worker finishes, so the
+		 * buffer goes out now instead of holding finished results back */
+		pthread_mutex_lock(&pipeline->done.lock);
+		idle = (pipeline->done.count == 0);
+		pthread_mutex_unlock(&pipeline->done.lock);
+		if(idle) flushOutput(buffer, &used, pipeline);
+		pipeline->writeSeconds += omp_get_wtime() - start;
+	}
+	flushOutput(buffer, &used, pipeline);
+	fflush(stdout);
+	free(buffer);
+	return NULL;
+}
+
+/* Formats one result as lcs-serial prints it, "length\nsubsequence\n"
+ */
+void writeResult(Job job, char* buffer, size_t* used, Pipeline pipeline){
+	char header[16];
+	int length = snprintf(header, sizeof(header), "%d\n", job->finalSize);
+	size_t n = 0, chunk;
+
+	if(*used + length > OUTPUT_BUFFER) flushOutput(buffer, used, pipeline);
+	memcpy(buffer + *used, header, length);
+	*used += length;
+	while(n < (size_t)job->finalSize){
+		if(*used == OUTPUT_BUFFER) flushOutput(buffer, used, pipeline);
+		chunk = MIN((size_t)job->finalSize - n, OUTPUT_BUFFER - *used);
+		memcpy(buffer + *used, job->subsequence + n, chunk);
+		*used += chunk;
+		n += chunk;
+	}
+	if(*used == OUTPUT_BUFFER) flushOutput(buffer, used, pipeline);
+	buffer[(*used)++] = '\n';
+}
+
+void flushOutput(char* buffer, size_t* used, Pipeline pipeline){
+	if(*used > 0 && fwrite(buffer, 1, *used, stdout) != *used){
+		fprintf(stderr, "Error writing the results\n");
+		exit(2);
+	}
+	pipeline->bytesWritten += *used;
+	*used = 0;
+}
+
+/* Function that reads the file into the job
+ * Builds the vertical and horizontal string and the cost table in the
+ * recycled buffers, each sequence is read in one block
+ * returns 1, or 0 after reporting the error on stderr
+ */
+int parseFile(Job job){
+	FILE* file;
+	int height, width, c;
+	size_t n;
+
+	if (!(file = fopen(job->fileName,"r"))){
+		fprintf(stderr, "Error opening file \"%s\"\n", job->fileName);
+		return 0;
+	}
+	if(fscanf(file, "%d %d", &height, &width) != 2 || height < 0 || width < 0){
+		fprintf(stderr, "Could not read height and width of \"%s\"\n", job->fileName);
+		fclose(file);
+		return 0;
+	}
+	while((c = fgetc(file)) != '\n' && c != EOF);
+
+	job->vectorHeight = (char*)grow(job->vectorHeight, &job->heightCapacity, (size_t)height + 2);
+	job->vectorWidth = (char*)grow(job->vectorWidth, &job->widthCapacity, (size_t)width + 2);
+	if(fread(job->vectorHeight + 1, 1, (size_t)height + 1, file) != (size_t)height + 1 ||
+	   job->vectorHeight[height + 1] != '\n' ||
+	   fread(job->vectorWidth + 1, 1, (size_t)width, file) != (size_t)width){
+		fprintf(stderr, "The sequences of \"%s\" do not match its header\n", job->fileName);
+		fclose(file);
+		return 0;
+	}
+	fclose(file);
+	job->vectorHeight[0] = '/';
+	job->vectorWidth[0] = '/';
+	job->height = height;
+	job->width = width;
+
+	job->costTable = (short*)grow(job->costTable, &job->costCapacity, sizeof(short) * ((size_t)height + width + 1));
+	for(n = 0; n <= (size_t)height + width; n++){
+		job->costTable[n] = cost(n);
+	}
+	return 1;
+}
+
+/* Function that fills the board of a pair in the scratch of the worker
+ * Two rows of values and the 2-bit move of every cell, the same moves
+ * lcs-serial records in its directions engine, so the output matches it
+ */
+void iterateBoard(Job job, Scratch scratch){
+	size_t columns = (size_t)job->width + 1;
+	size_t cells = ((size_t)job->height + 1) * columns;
+	short *previous, *current, *aux;
+	short value;
+	size_t cell;
+	unsigned char* directions;
+	int i, j, direction;
+
+	scratch->rows = (short*)grow(scratch->rows, &scratch->rowsCapacity, sizeof(short) * 2 * columns);
+	directions = scratch->directions = (unsigned char*)grow(scratch->directions, &scratch->directionsCapacity, (cells + 3) / 4);
+	memset(directions, 0, (cells + 3) / 4);
+	previous = scratch->rows;
+	current = scratch->rows + columns;
+	memset(previous, 0, sizeof(short) * columns);
+
+	for(i = 1; i <= job->height; i++){
+		current[0] = 0;
+		for(j = 1; j <= job->width; j++){
+			if(job->vectorHeight[i] == job->vectorWidth[j]){
+				value = previous[j - 1] + job->costTable[i + j];
+			}else{
+				value = MAX(previous[j], current[j - 1]);
+			}
+			current[j] = value;
+			if((previous[j] != value) && (current[j - 1] != value)){
+				direction = DIAGONAL;
+			}else if(job->vectorHeight[i] == job->vectorWidth[j]){
+				direction = DIAGONAL;
+			}else if(current[j - 1] == value){
+				direction = LEFT;
+			}else{
+				direction = UP;
+			}
+			cell = (size_t)i * columns + j;
+			directions[cell / 4] |= direction << (2 * (cell % 4));
+		}
+		aux = previous;
+		previous = current;
+		current = aux;
+	}
+	job->finalSize = previous[job->width];
+}
+
+/* Function that follows the moves back from the bottom right cell
+ * and fills the subsequence
+ */
+void backtrack(Job job, Scratch scratch){
+	size_t columns = (size_t)job->width + 1;
+	int i = job->height, j = job->width, aux = job->finalSize;
+	size_t cell;
+
+	job->subsequence = (char*)grow(job->subsequence, &job->subsequenceCapacity, (size_t)job->finalSize + 1);
+	while(aux > 0){
+		cell = (size_t)i * columns + j;
+		switch((scratch->directions[cell / 4] >> (2 * (cell % 4))) & 3){
+			case DIAGONAL:
+				job->subsequence[--aux] = job->vectorHeight[i];
+				i--;
+				j--;
+				break;
+			case LEFT:
+				j--;
+				break;
+			default:
+				i--;
+		}
+	}
+}
+
+/* Function to add computation time
+ * returns 1 always
+ */
+short cost(int x){
+	int i, n_iter = 20;
+	double dcost = 0;
+	for(i = 0; i < n_iter; i++)
+		dcost += pow(sin((double) x),2) + pow(cos((double) x),2);
+	return (short) (dcost / n_iter + 0.1);
+}
+
+/*
+ * Clears the resourses used
+ */
+void cleanAll(Pipeline pipeline){
+	Job job;
+	long n;
+
+	closeQueue(&pipeline->free);
+	while((job = pop(&pipeline->free)) != NULL){
+		free(job->vectorHeight);
+		free(job->vectorWidth);
+		free(job->costTable);
+		free(job->subsequence);
+		free(job);
+	}
+	for(n = 0; n < pipeline->numFiles; n++){
+		free(pipeline->fileNames[n]);
+	}
+	free(pipeline->fileNames);
+	free(pipeline->computeSeconds);
+}
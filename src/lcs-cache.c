@@ -0,0 +1,504 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define CACHE_MAGIC "LCSCACH2"
+#define DEFAULT_CAPACITY (64 << 20)
+#define MIN_SLOTS 1024
+#define COST_MODEL 1		//cost(): sin^2 + cos^2 averaged over 20 iterations
+
+#define EMPTY 0
+#define USED 1
+
+/* The cache is one file mapped by every process: a header with the
+ * counters, an open addressing table of slots keyed by the pair hash,
+ * and an arena holding the subsequences back to back
+ * Lookups run under a shared flock and only touch the counters and the
+ * LRU clocks with atomics, inserts and evictions take the exclusive one
+ * Evictions shift the rest of the probe run back instead of leaving
+ * tombstones, so misses stop at the first empty slot however many
+ * entries were evicted
+ */
+typedef struct {
+	char magic[8];
+	uint64_t capacity;	//arena bytes
+	uint64_t slots;
+	uint64_t used;		//arena bytes in use, the arena is kept compact
+	uint64_t entries;
+	uint64_t clock;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+}cache_header_t;
+
+typedef struct {
+	uint64_t key[2];
+	uint64_t offset;
+	uint64_t lastUse;
+	int32_t length;		//LCS length printed by the engine
+	uint32_t size;		//subsequence bytes
+	uint32_t state;		//EMPTY or USED
+	uint32_t pad;
+}cache_slot_t;
+
+typedef struct {
+	int fd;
+	size_t mapSize;
+	cache_header_t* header;
+	cache_slot_t* slots;
+	char* arena;
+}cache_t;
+
+typedef cache_t* Cache;
+
+typedef struct {
+	int height;
+	int width;
+	char* vectorHeight;
+	char* vectorWidth;
+	uint64_t key[2];
+}board_t;
+
+typedef board_t* Board;
+
+Board parseFile(char* fileName, char* engine);
+void hashSequence(char* vector, int length, uint64_t* hash);
+uint64_t mix(uint64_t x);
+Cache openCache(char* path, uint64_t capacity);
+cache_slot_t* findSlot(Cache cache, uint64_t* key, short forInsert);
+void deleteSlot(Cache cache, cache_slot_t* slot);
+short lookupCache(Cache cache, Board board, int* length, char** subsequence);
+void evictCache(Cache cache, uint64_t needed, uint64_t maxEntries);
+void insertCache(Cache cache, Board board, int length, char* subsequence, uint32_t size);
+char* runEngine(char* engine, char* fileName, size_t* outputSize);
+void printStats(Cache cache);
+void cleanAll(Board board, Cache cache);
+
+int main(int argc, char* argv[]){
+
+	char* path = getenv("LCS_CACHE");
+	char* size = getenv("LCS_CACHE_SIZE");
+	uint64_t capacity = (size && atoll(size) > 0) ? (uint64_t)atoll(size) : DEFAULT_CAPACITY;
+	char* subsequence;
+	char* output;
+	char* line;
+	size_t outputSize;
+	int length;
+
+	if(path == NULL || *path == '\0') path = "lcs.cache";
+	if(argc == 2 && !strcmp(argv[1], "-s")){
+		Cache cache = openCache(path, capacity);
+		printStats(cache);
+		cleanAll(NULL, cache);
+		return 0;
+	}
+	if(argc < 3){
+		printf("Usage: %s engine file.in | -s\n", argv[0]);
+		exit(1);
+	}
+
+	Board board = parseFile(argv[2], argv[1]);
+	Cache cache = openCache(path, capacity);
+
+	if(lookupCache(cache, board, &length, &subsequence)){
+		fprintf(stderr, "cache: hit\n");
+		printf("%d\n", length);
+		printf("%s\n", subsequence);
+		free(subsequence);
+		cleanAll(board, cache);
+		return 0;
+	}
+	fprintf(stderr, "cache: miss\n");
+
+	output = runEngine(argv[1], argv[2], &outputSize);
+	fwrite(output, 1, outputSize, stdout);
+	fflush(stdout);
+	/* only a complete "length\nsubsequence\n" result is kept */
+	if((line = memchr(output, '\n', outputSize)) != NULL && sscanf(output, "%d", &length) == 1 &&
+	   output[outputSize - 1] == '\n' && line < output + outputSize - 1){
+		line++;
+		insertCache(cache, board, length, line, (uint32_t)(output + outputSize - 1 - line));
+	}
+	free(output);
+	cleanAll(board, cache);
+	return 0;
+}
+
+/* Function that reads the file and hashes the pair
+ * Same format as the engines, the matrix is never allocated
+ * The key covers the engine, another one may print a different subsequence
+ * of the same length, but not the order of the pair: an LCS of the pair is
+ * also one of the swapped pair
+ * filename, the name of the file to be read; engine, the binary that solves it
+ * returns the board
+ */
+Board parseFile(char* fileName, char* engine){
+	FILE* file;
+	int height;
+	int width;
+	int c;
+	char* vectorHeight;
+	char* vectorWeidth;
+	uint64_t hashHeight[2];
+	uint64_t hashWidth[2];
+	uint64_t hashEngine[2];
+	uint64_t* first;
+	uint64_t* second;
+	char* name = strrchr(engine, '/') ? strrchr(engine, '/') + 1 : engine;
+	char* label;
+	size_t n = 1;
+
+	if (!(file = fopen(fileName,"r"))){
+	    printf("Error opening file \"%s\"\n", fileName);
+	    exit(2);
+	}
+	if(fscanf(file, "%d %d\n", &height, &width) != 2){
+	    printf("Could not read height and width");
+	    exit(3);
+	}
+	if(!(vectorHeight = (char*) malloc(sizeof(char)*(height + 1)))||
+	   !(vectorWeidth = (char*) malloc(sizeof(char)*(width + 1)))){
+		    printf("Error allocating row pointers for board.\n");
+		    exit(4);
+	}
+
+	while((c = fgetc(file)) != '\n' && c != EOF){
+		 if(n <= height) vectorHeight[n++] = (char)c;
+	}
+	vectorHeight[0] = '/';
+
+	n = 1;
+	while((c = fgetc(file)) != '\n' && c != EOF){
+		if(n <= width) vectorWeidth[n++] = (char)c;
+	}
+	vectorWeidth[0] = '/';
+	fclose(file);
+	file = NULL;
+
+	Board result = (Board)malloc(sizeof(board_t));
+
+	result->height =  height;
+	result->width = width;
+	result->vectorHeight = vectorHeight;
+	result->vectorWidth = vectorWeidth;
+
+	hashSequence(vectorHeight, height, hashHeight);
+	hashSequence(vectorWeidth, width, hashWidth);
+	label = (char*)malloc(strlen(name) + 2);
+	label[0] = '/';
+	strcpy(label + 1, name);
+	hashSequence(label, strlen(name), hashEngine);
+	free(label);
+	/* the key does not depend on the order of the pair, like the CHANGE swap of lcs-mpi */
+	if(hashHeight[0] < hashWidth[0] || (hashHeight[0] == hashWidth[0] && hashHeight[1] <= hashWidth[1])){
+		first = hashHeight;
+		second = hashWidth;
+	}else{
+		first = hashWidth;
+		second = hashHeight;
+	}
+	result->key[0] = mix(first[0] ^ mix(second[0] ^ mix(hashEngine[0] ^ COST_MODEL)));
+	result->key[1] = mix(first[1] + 0x9e3779b97f4a7c15ULL * mix(second[1] + hashEngine[1] + COST_MODEL));
+
+	return result;
+}
+
+/* Finalizer of splitmix64
+ * returns the mixed value
+ */
+uint64_t mix(uint64_t x){
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+}
+
+/* Hashes a sequence eight bytes at a time into two independent 64-bit lanes
+ * vector, 1-based; length, its size; hash, the two lanes
+ */
+void hashSequence(char* vector, int length, uint64_t* hash){
+	uint64_t word;
+	int n = 1;
+
+	hash[0] = 0x243f6a8885a308d3ULL ^ (uint64_t)length;
+	hash[1] = 0x13198a2e03707344ULL + (uint64_t)length;
+	for(; n + 8 <= length + 1; n += 8){
+		memcpy(&word, vector + n, 8);
+		hash[0] = mix(hash[0] ^ word);
+		hash[1] = mix(hash[1] + word * 0x9e3779b97f4a7c15ULL);
+	}
+	word = 0;
+	memcpy(&word, vector + n, length + 1 - n);
+	hash[0] = mix(hash[0] ^ word);
+	hash[1] = mix(hash[1] + word * 0x9e3779b97f4a7c15ULL);
+}
+
+/* Opens the cache file, creating it with the given arena capacity
+ * The first process to get the exclusive lock writes the header
+ * path, the cache file; capacity, the arena bytes of a new cache
+ * returns the mapped cache
+ */
+Cache openCache(char* path, uint64_t capacity){
+	Cache cache = (Cache)malloc(sizeof(cache_t));
+	cache_header_t header;
+	struct stat info;
+	uint64_t slots = capacity / 1024;
+	char* map;
+
+	if(slots < MIN_SLOTS) slots = MIN_SLOTS;
+	if((cache->fd = open(path, O_RDWR | O_CREAT, 0644)) < 0){
+		printf("Error opening cache \"%s\"\n", path);
+		exit(2);
+	}
+	flock(cache->fd, LOCK_EX);
+	fstat(cache->fd, &info);
+	if(info.st_size == 0){
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+		header.capacity = capacity;
+		header.slots = slots;
+		if(ftruncate(cache->fd, sizeof(header) + slots * sizeof(cache_slot_t) + capacity) ||
+		   pwrite(cache->fd, &header, sizeof(header), 0) != sizeof(header)){
+			printf("Error creating cache \"%s\"\n", path);
+			exit(4);
+		}
+	}else if(pread(cache->fd, &header, sizeof(header), 0) != sizeof(header) ||
+	         memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic))){
+		printf("\"%s\" is not a result cache\n", path);
+		exit(3);
+	}
+	flock(cache->fd, LOCK_UN);
+
+	cache->mapSize = sizeof(header) + header.slots * sizeof(cache_slot_t) + header.capacity;
+	map = mmap(NULL, cache->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, cache->fd, 0);
+	if(map == MAP_FAILED){
+		printf("Error mapping cache \"%s\"\n", path);
+		exit(4);
+	}
+	cache->header = (cache_header_t*)map;
+	cache->slots = (cache_slot_t*)(map + sizeof(cache_header_t));
+	cache->arena = map + sizeof(cache_header_t) + header.slots * sizeof(cache_slot_t);
+	return cache;
+}
+
+/* Linear probing over the slot table
+ * forInsert, return the empty slot that ends the run when key is missing
+ * returns the slot holding key, a free slot for it, or NULL
+ */
+cache_slot_t* findSlot(Cache cache, uint64_t* key, short forInsert){
+	uint64_t slots = cache->header->slots;
+	uint64_t n, index = key[0] % slots;
+	cache_slot_t* slot;
+
+	for(n = 0; n < slots; n++){
+		slot = &cache->slots[(index + n) % slots];
+		if(slot->state == EMPTY){
+			return forInsert ? slot : NULL;
+		}
+		if(slot->key[0] == key[0] && slot->key[1] == key[1]){
+			return slot;
+		}
+	}
+	return NULL;
+}
+
+/* Empties a slot with backward shift deletion
+ * Every later entry of the probe run whose home is not between the hole
+ * and itself moves back into the hole, so no run is ever broken
+ * Called under the exclusive lock
+ */
+void deleteSlot(Cache cache, cache_slot_t* slot){
+	uint64_t slots = cache->header->slots;
+	uint64_t hole = slot - cache->slots, next = hole, home;
+
+	cache->slots[hole].state = EMPTY;
+	for(;;){
+		next = (next + 1) % slots;
+		if(cache->slots[next].state == EMPTY) return;
+		home = cache->slots[next].key[0] % slots;
+		if((hole <= next) ? (hole < home && home <= next) : (hole < home || home <= next)) continue;
+		cache->slots[hole] = cache->slots[next];
+		cache->slots[next].state = EMPTY;
+		hole = next;
+	}
+}
+
+/* Function that looks the pair up under a shared lock
+ * Counts the hit or the miss and refreshes the LRU clock of the entry
+ * length, subsequence, the cached result on a hit
+ * returns 1 on a hit, 0 on a miss
+ */
+short lookupCache(Cache cache, Board board, int* length, char** subsequence){
+	cache_slot_t* slot;
+	short hit = 0;
+
+	flock(cache->fd, LOCK_SH);
+	if((slot = findSlot(cache, board->key, 0)) != NULL){
+		*length = slot->length;
+		*subsequence = (char*)malloc(slot->size + 1);
+		memcpy(*subsequence, cache->arena + slot->offset, slot->size);
+		(*subsequence)[slot->size] = '\0';
+		__atomic_store_n(&slot->lastUse, __atomic_add_fetch(&cache->header->clock, 1, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+		__atomic_add_fetch(&cache->header->hits, 1, __ATOMIC_RELAXED);
+		hit = 1;
+	}else{
+		__atomic_add_fetch(&cache->header->misses, 1, __ATOMIC_RELAXED);
+	}
+	flock(cache->fd, LOCK_UN);
+	return hit;
+}
+
+/* Function that evicts least recently used entries until needed bytes are
+ * free and at most maxEntries are left
+ * Then compacts the arena so the free space is one run at its end
+ * Called under the exclusive lock
+ */
+void evictCache(Cache cache, uint64_t needed, uint64_t maxEntries){
+	cache_header_t* header = cache->header;
+	cache_slot_t* oldest;
+	cache_slot_t** live;
+	cache_slot_t* swap;
+	uint64_t n, m, count = 0, offset = 0;
+
+	while((header->capacity - header->used < needed || header->entries > maxEntries) && header->entries > 0){
+		oldest = NULL;
+		for(n = 0; n < header->slots; n++){
+			if(cache->slots[n].state == USED && (oldest == NULL || cache->slots[n].lastUse < oldest->lastUse)){
+				oldest = &cache->slots[n];
+			}
+		}
+		header->used -= oldest->size;
+		header->entries--;
+		header->evictions++;
+		deleteSlot(cache, oldest);
+	}
+
+	live = (cache_slot_t**)malloc(sizeof(cache_slot_t*) * (header->entries + 1));
+	for(n = 0; n < header->slots; n++){
+		if(cache->slots[n].state == USED) live[count++] = &cache->slots[n];
+	}
+	/* insertion sort by offset, then slide every entry down */
+	for(n = 1; n < count; n++){
+		for(m = n; m > 0 && live[m - 1]->offset > live[m]->offset; m--){
+			swap = live[m];
+			live[m] = live[m - 1];
+			live[m - 1] = swap;
+		}
+	}
+	for(n = 0; n < count; n++){
+		memmove(cache->arena + offset, cache->arena + live[n]->offset, live[n]->size);
+		live[n]->offset = offset;
+		offset += live[n]->size;
+	}
+	header->used = offset;
+	free(live);
+}
+
+/* Function that stores a result under the exclusive lock
+ * Results larger than the whole arena are not cached
+ * length, the LCS length; subsequence, size, its bytes
+ */
+void insertCache(Cache cache, Board board, int length, char* subsequence, uint32_t size){
+	cache_header_t* header = cache->header;
+	cache_slot_t* slot;
+
+	if(size > header->capacity) return;
+	flock(cache->fd, LOCK_EX);
+	if(findSlot(cache, board->key, 0) == NULL){
+		/* the table stays under 3/4 full to keep the probes short */
+		if(header->capacity - header->used < size || header->entries + 1 > header->slots * 3 / 4){
+			evictCache(cache, size, header->slots * 3 / 4 - 1);
+		}
+		slot = findSlot(cache, board->key, 1);
+		memcpy(cache->arena + header->used, subsequence, size);
+		slot->key[0] = board->key[0];
+		slot->key[1] = board->key[1];
+		slot->offset = header->used;
+		slot->size = size;
+		slot->length = length;
+		slot->lastUse = ++header->clock;
+		slot->state = USED;
+		header->used += size;
+		header->entries++;
+	}
+	msync(cache->header, cache->mapSize, MS_ASYNC);
+	flock(cache->fd, LOCK_UN);
+}
+
+/* Runs an engine on the file and captures everything it prints
+ * engine, the binary; fileName, its argument; outputSize, the bytes read
+ * returns the output
+ */
+char* runEngine(char* engine, char* fileName, size_t* outputSize){
+	size_t size = 1 << 16;
+	char* output = (char*)malloc(size);
+	int pipeFd[2];
+	int status;
+	ssize_t got;
+	pid_t pid;
+
+	*outputSize = 0;
+	if(pipe(pipeFd) || (pid = fork()) < 0){
+		printf("Error starting \"%s\"\n", engine);
+		exit(2);
+	}
+	if(pid == 0){
+		dup2(pipeFd[1], STDOUT_FILENO);
+		close(pipeFd[0]);
+		close(pipeFd[1]);
+		execlp(engine, engine, fileName, (char*)NULL);
+		_exit(127);
+	}
+	close(pipeFd[1]);
+	while((got = read(pipeFd[0], output + *outputSize, size - *outputSize)) > 0){
+		*outputSize += got;
+		if(*outputSize == size){
+			size *= 2;
+			output = (char*)realloc(output, size);
+		}
+	}
+	close(pipeFd[0]);
+	waitpid(pid, &status, 0);
+	if(!WIFEXITED(status) || WEXITSTATUS(status) != 0){
+		fwrite(output, 1, *outputSize, stdout);
+		exit(WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+	}
+	return output;
+}
+
+/* Prints the counters of the cache
+ */
+void printStats(Cache cache){
+	cache_header_t* header = cache->header;
+
+	flock(cache->fd, LOCK_SH);
+	printf("entries %llu, %llu of %llu bytes\n", (unsigned long long)header->entries,
+	       (unsigned long long)header->used, (unsigned long long)header->capacity);
+	printf("hits %llu, misses %llu, evictions %llu\n", (unsigned long long)header->hits,
+	       (unsigned long long)header->misses, (unsigned long long)header->evictions);
+	flock(cache->fd, LOCK_UN);
+}
+
+/*
+ * Clears the resourses used
+ */
+void cleanAll(Board board, Cache cache){
+
+	if(board != NULL){
+		free(board->vectorHeight);
+		free(board->vectorWidth);
+		free(board);
+	}
+	munmap(cache->header, cache->mapSize);
+	close(cache->fd);
+	free(cache);
+}
@@ -0,0 +1,420 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+#define MAX(x, y) ( ((x) > (y)) ? (x) : (y) )
+#define MIN(x, y) ( ((x) > (y)) ? (y) : (x) )
+
+#define BAND 128		//columns on each side of the diagonal, the second pass uses twice as many
+#define EXACT_CELLS (4L * 1024 * 1024)	//smaller inputs are solved exactly
+#define SLACK 0.005		//share of the lower bound added to the top of the interval
+#define SEED_K 12		//k-mer length of the seeds that place the band
+#define MAX_OCCURRENCES 8	//k-mers more frequent than this in vectorWidth are repeats, not seeds
+#define SEGMENTS 64		//the rows are cut in this many parts, each gets its own offset
+#define MIN_VOTES 3		//seeds that must agree on the offset of a part
+#define HASH_BASE 0x100000001B3ULL
+
+typedef struct {
+	int height;		//height <= width
+	int width;
+	char* vectorHeight;
+	char* vectorWidth;
+	short* costTable;
+	short maxCost;
+	int lower;		//length of a common subsequence found
+	int upper;		//no common subsequence is longer
+	double estimate;
+	int high;		//top of the interval around the estimate
+	int exact;
+	int limited;		//the band edge limits the lower bound, a wider band found more
+}board_t;
+
+typedef board_t* Board;
+
+short cost(int x);
+Board parseFile(char* fileName);
+int upperBound(Board board);
+uint64_t hashKmer(char* vector, int k);
+int compareInts(const void* a, const void* b);
+int* bandCentre(int band, Board board);
+int bandLowerBound(int band, int* centre, Board board);
+int blockLCS(int i0, int i1, int j0, int j1, int* row, Board board);
+void extrapolate(int band, Board board);
+void printResults(board_t* board);
+void cleanAll(board_t* board);
+
+int main(int argc, char* argv[]){
+
+	if(argc < 2){
+		printf("Usage: %s file.in [band]\n", argv[0]);
+		exit(1);
+	}
+	char* fileName = argv[1];
+	int band = (argc > 2 && atoi(argv[2]) > 0) ? atoi(argv[2]) : BAND;
+	Board board = parseFile(fileName);
+	int* row;
+
+	board->upper = upperBound(board);
+	if((long)board->height * board->width <= EXACT_CELLS){
+		row = (int*)calloc(board->width + 1, sizeof(int));
+		board->lower = board->upper = blockLCS(1, board->height, 1, board->width, row, board);
+		board->estimate = board->high = board->lower;
+		board->exact = 1;
+		free(row);
+	}else{
+		extrapolate(band, board);
+	}
+	printResults(board);
+	cleanAll(board);
+	return 0;
+}
+
+/* Upper bound from the character counts
+ * Each character can be matched at most as many times as it appears
+ * in the sequence where it is rarer, and each match adds at most maxCost
+ * returns the bound
+ */
+int upperBound(Board board){
+	long countHeight[256] = {0}, countWidth[256] = {0};
+	long matches = 0;
+	int n;
+
+	for(n = 1; n <= board->height; n++) countHeight[(unsigned char)board->vectorHeight[n]]++;
+	for(n = 1; n <= board->width; n++) countWidth[(unsigned char)board->vectorWidth[n]]++;
+	for(n = 0; n < 256; n++) matches += MIN(countHeight[n], countWidth[n]);
+	return (int)MIN(matches * board->maxCost, (long)board->height * board->maxCost);
+}
+
+/* Polynomial hash of the k characters from vector
+ */
+uint64_t hashKmer(char* vector, int k){
+	uint64_t hash = 0;
+	int n;
+
+	for(n = 0; n < k; n++){
+		hash = hash * HASH_BASE + (unsigned char)vector[n];
+	}
+	return hash;
+}
+
+int compareInts(const void* a, const void* b){
+	int x = *(const int*)a, y = *(const int*)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Function that places the band on every row
+ * Every k-th k-mer of vectorHeight is looked up in an index of vectorWidth,
+ * as in lcs-anchor, and each hit votes for its offset j - i. The rows are cut
+ * in SEGMENTS parts; a part where MIN_VOTES hits fall within half a band
+ * of each other gets their median offset. Rows between two such parts
+ * interpolate, rows before the first or after the last keep its offset
+ * returns the column at the centre of the band per row, NULL without votes
+ */
+int* bandCentre(int band, Board board){
+	int height = board->height, width = board->width;
+	int* centre = (int*)malloc(sizeof(int) * (height + 1));
+	int kmersHeight = MAX(height - SEED_K + 1, 0), kmersWidth = MAX(width - SEED_K + 1, 0);
+	int segment = MAX(1, (height + SEGMENTS - 1) / SEGMENTS);
+	int *start, *positions, *offsets, *segmentStart, *controlRow, *controlOffset;
+	int i, j, n, found, count, controls = 0, first, last, best, median;
+	uint64_t buckets = 1, top = 1, hash = 0, mask, bucket;
+
+	if(kmersHeight == 0 || kmersWidth == 0){
+		free(centre);
+		return NULL;
+	}
+
+	/* index of the k-mers of vectorWidth, positions grouped by bucket */
+	while(buckets < 2 * (uint64_t)kmersWidth) buckets <<= 1;
+	mask = buckets - 1;
+	start = (int*)calloc(buckets + 1, sizeof(int));
+	positions = (int*)malloc(sizeof(int) * kmersWidth);
+	offsets = (int*)malloc(sizeof(int) * ((size_t)kmersHeight * MAX_OCCURRENCES));
+	segmentStart = (int*)malloc(sizeof(int) * (SEGMENTS + 1));
+	controlRow = (int*)malloc(sizeof(int) * SEGMENTS);
+	controlOffset = (int*)malloc(sizeof(int) * SEGMENTS);
+	if(!start || !positions || !offsets || !segmentStart || !controlRow || !controlOffset){
+		printf("Error allocating the k-mer index.\n");
+		exit(4);
+	}
+	for(n = 1; n < SEED_K; n++) top *= HASH_BASE;
+	for(j = 1; j <= kmersWidth; j++){
+		hash = (j == 1) ? hashKmer(board->vectorWidth + 1, SEED_K)
+		     : (hash - top * (unsigned char)board->vectorWidth[j - 1]) * HASH_BASE
+		       + (unsigned char)board->vectorWidth[j + SEED_K - 1];
+		start[(hash & mask) + 1]++;
+	}
+	for(bucket = 0; bucket < buckets; bucket++) start[bucket + 1] += start[bucket];
+	for(j = 1; j <= kmersWidth; j++){
+		hash = (j == 1) ? hashKmer(board->vectorWidth + 1, SEED_K)
+		     : (hash - top * (unsigned char)board->vectorWidth[j - 1]) * HASH_BASE
+		       + (unsigned char)board->vectorWidth[j + SEED_K - 1];
+		positions[start[hash & mask]++] = j;
+	}
+	for(bucket = buckets; bucket > 0; bucket--) start[bucket] = start[bucket - 1];
+	start[0] = 0;
+
+	/* the votes, in row order, so each part is a contiguous run */
+	count = 0;
+	for(i = 1; i <= kmersHeight; i++){
+		if((i - 1) % segment == 0) segmentStart[(i - 1) / segment] = count;
+		hash = (i == 1) ? hashKmer(board->vectorHeight + 1, SEED_K)
+		     : (hash - top * (unsigned char)board->vectorHeight[i - 1]) * HASH_BASE
+		       + (unsigned char)board->vectorHeight[i + SEED_K - 1];
+		/* only k-mers that do not overlap vote, one chance match is one vote */
+		if((i - 1) % SEED_K) continue;
+		bucket = hash & mask;
+		found = 0;
+		for(n = start[bucket]; n < start[bucket + 1] && found <= MAX_OCCURRENCES; n++){
+			if(!memcmp(board->vectorHeight + i, board->vectorWidth + positions[n], SEED_K)) found++;
+		}
+		if(found == 0 || found > MAX_OCCURRENCES) continue;
+		for(n = start[bucket]; n < start[bucket + 1]; n++){
+			if(!memcmp(board->vectorHeight + i, board->vectorWidth + positions[n], SEED_K)){
+				offsets[count++] = positions[n] - i;
+			}
+		}
+	}
+	for(n = (kmersHeight - 1) / segment + 1; n <= SEGMENTS; n++) segmentStart[n] = count;
+
+	/* the offset most votes of a part agree on, within half a band */
+	for(n = 0; n < SEGMENTS; n++){
+		qsort(offsets + segmentStart[n], segmentStart[n + 1] - segmentStart[n], sizeof(int), compareInts);
+		best = 0;
+		median = 0;
+		for(first = last = segmentStart[n]; first < segmentStart[n + 1]; first++){
+			while(last < segmentStart[n + 1] && offsets[last] - offsets[first] <= band / 2) last++;
+			if(last - first > best){
+				best = last - first;
+				median = offsets[(first + last - 1) / 2];
+			}
+		}
+		if(best >= MIN_VOTES){
+			controlRow[controls] = MIN(height, n * segment + segment / 2 + 1);
+			controlOffset[controls++] = median;
+		}
+	}
+
+	for(i = 0, n = 0; i <= height && controls > 0; i++){
+		while(n < controls && controlRow[n] < i) n++;
+		if(n == 0) centre[i] = i + controlOffset[0];
+		else if(n == controls) centre[i] = i + controlOffset[controls - 1];
+		else centre[i] = i + controlOffset[n - 1] + (int)((double)(controlOffset[n] - controlOffset[n - 1]) *
+		                 (i - controlRow[n - 1]) / (controlRow[n] - controlRow[n - 1]));
+	}
+	if(controls == 0){
+		free(centre);
+		centre = NULL;
+	}
+	free(start);
+	free(positions);
+	free(offsets);
+	free(segmentStart);
+	free(controlRow);
+	free(controlOffset);
+	return centre;
+}
+
+/* Lower bound from the LCS recurrence restricted to a band of band
+ * columns on each side of the centre of every row
+ * Cells out of the band keep an older row, still the value of some
+ * common subsequence, so the result is always achievable
+ * returns the bound, exact when the best path stays in the band
+ */
+int bandLowerBound(int band, int* centre, Board board){
+	int* row = (int*)calloc(board->width + 1, sizeof(int));
+	int i, j, j0, j1, diag, up, value;
+
+	for(i = 1; i <= board->height; i++){
+		j0 = MAX(1, centre[i] - band);
+		j1 = MIN(board->width, centre[i] + band);
+		if(j0 > j1) continue;
+		diag = row[j0 - 1];
+		for(j = j0; j <= j1; j++){
+			up = row[j];
+			if(board->vectorHeight[i] == board->vectorWidth[j]){
+				value = diag + board->costTable[i + j];
+			}else{
+				value = MAX(up, row[j - 1]);
+			}
+			diag = up;
+			row[j] = value;
+		}
+	}
+	value = row[board->width];
+	for(j = 0; j <= board->width; j++) value = MAX(value, row[j]);
+	free(row);
+	return value;
+}
+
+/* Exact LCS of rows i0..i1 and columns j0..j1, one row at a time
+ * row, scratch space for j1 - j0 + 2 values
+ * returns the LCS of the block
+ */
+int blockLCS(int i0, int i1, int j0, int j1, int* row, Board board){
+	int i, j, diag, up, value;
+
+	for(j = 0; j <= j1 - j0 + 1; j++) row[j] = 0;
+	for(i = i0; i <= i1; i++){
+		diag = 0;
+		for(j = j0; j <= j1; j++){
+			up = row[j - j0 + 1];
+			if(board->vectorHeight[i] == board->vectorWidth[j]){
+				value = diag + board->costTable[i + j];
+			}else{
+				value = MAX(up, row[j - j0]);
+			}
+			diag = up;
+			row[j - j0 + 1] = value;
+		}
+	}
+	return row[j1 - j0 + 1];
+}
+
+/* Estimate from two band widths around the same centres
+ * The band follows the diagonal that joins both corners and, when the
+ * seeds agree on offsets, also the seeds; the one that finds more is kept,
+ * repeats can make the seeds point away from the best path
+ * Doubling the band recovers paths that wander further from the centre,
+ * and what it gains roughly halves with every doubling, so the gain of the
+ * last doubling is also about what a full matrix would still add
+ * The interval goes from the wider band, always achievable, to twice that
+ * gain plus SLACK of the bound, a heuristic; when the doubling gained
+ * anything the band edge limits the result and nothing bounds what is left
+ * Runs in O((height + width) * band)
+ */
+void extrapolate(int band, Board board){
+	int* centre = (int*)malloc(sizeof(int) * (board->height + 1));
+	int* seeded = bandCentre(band, board);
+	double slope = (double)board->width / board->height;
+	int narrow, wide, gain, i;
+
+	for(i = 0; i <= board->height; i++) centre[i] = (int)(i * slope);
+	narrow = bandLowerBound(band, centre, board);
+	wide = bandLowerBound(2 * band, centre, board);
+	if(seeded != NULL && (i = bandLowerBound(2 * band, seeded, board)) > wide){
+		wide = i;
+		narrow = bandLowerBound(band, seeded, board);
+	}
+	gain = wide - narrow;
+
+	free(centre);
+	free(seeded);
+	board->limited = (gain > 0);
+	board->lower = wide;
+	board->estimate = MIN(wide + gain, board->upper);
+	board->high = MIN(wide + 2 * gain + (int)ceil(SLACK * wide), board->upper);
+	board->exact = (board->lower == board->upper);
+}
+
+/* Function that reads the file and builds the board
+ * Builds the vertical and horizontal string and the cost table,
+ * the shorter sequence becomes the vertical one
+ * filename, the name of the file to be read
+ * returns the board
+ */
+Board parseFile(char* fileName){
+	FILE* file;
+	int height;
+	int width;
+	int c;
+	char* vectorHeight;
+	char* vectorWidth;
+	char* vectorAux;
+	short* costTable;
+	short maxCost = 0;
+	size_t n = 1;
+
+	if (!(file = fopen(fileName,"r"))){
+	    printf("Error opening file \"%s\"\n", fileName);
+	    exit(2);
+	}
+	if(fscanf(file, "%d %d\n", &height, &width) == 0){
+	    printf("Could not read height and width");
+	    exit(3);
+	}
+	if(!(vectorHeight = (char*) malloc(sizeof(char)*(height + 1)))||
+	   !(vectorWidth = (char*) malloc(sizeof(char)*(width + 1)))){
+		    printf("Error allocating row pointers for board.\n");
+		    exit(4);
+	}
+
+	while((c = fgetc(file)) != '\n' && c != EOF){
+		 vectorHeight[n++] = (char)c;
+	}
+	vectorHeight[0] = '/';
+
+	n = 1;
+	while((c = fgetc(file)) != '\n' && c != EOF){
+		vectorWidth[n++] = (char)c;
+	}
+	vectorWidth[0] = '/';
+	fclose(file);
+	file = NULL;
+
+	if(height > width){
+		c = height; height = width; width = c;
+		vectorAux = vectorHeight; vectorHeight = vectorWidth; vectorWidth = vectorAux;
+	}
+
+	costTable = (short*)malloc(sizeof(short) * (height + width + 1));
+	for(n = 0; n < height + width + 1; n++){
+		costTable[n] = cost(n);
+		if(n >= 2) maxCost = MAX(maxCost, costTable[n]);
+	}
+
+	Board result = (Board)malloc(sizeof(board_t));
+
+	result->height = height;
+	result->width = width;
+	result->vectorHeight = vectorHeight;
+	result->vectorWidth = vectorWidth;
+	result->costTable = costTable;
+	result->maxCost = maxCost;
+	result->lower = 0;
+	result->upper = 0;
+	result->estimate = 0;
+	result->high = 0;
+	result->exact = 0;
+	result->limited = 0;
+
+	return result;
+}
+
+/* Prints the estimate, the heuristic interval around it, the exact bounds
+ * and how much the estimate can be trusted: exact, high (doubling the band
+ * found nothing more) or low (the band edge limits the result)
+ */
+void printResults(board_t* board){
+	printf("estimate %.0f\n", board->estimate);
+	printf("interval %d %d\n", board->lower, board->high);
+	printf("bounds %d %d\n", board->lower, board->upper);
+	if(board->exact) printf("confidence exact\n");
+	else if(board->limited) printf("confidence low (the band edge limits the result)\n");
+	else printf("confidence high (a wider band found nothing more)\n");
+}
+
+/* Function to add computation time
+ * returns 1 always
+ */
+short cost(int x){
+	int i, n_iter = 20;
+	double dcost = 0;
+	for(i = 0; i < n_iter; i++)
+		dcost += pow(sin((double) x),2) + pow(cos((double) x),2);
+	return (short) (dcost / n_iter + 0.1);
+}
+
+/*
+ * Clears the resourses used
+ */
+void cleanAll(board_t* board){
+
+	free(board->vectorHeight);
+	free(board->vectorWidth);
+	free(board->costTable);
+	free(board);
+}
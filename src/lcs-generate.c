@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_ALPHABET 62
+#define BUFFER_SIZE (1 << 20)
+
+typedef struct {
+	long long height;
+	long long width;
+	char alphabet[MAX_ALPHABET + 1];
+	int alphabetSize;
+	double mutation;	//chance a kept character is replaced
+	unsigned long long seed;
+	FILE* file;
+	char* buffer;
+	int used;
+}generator_t;
+
+typedef generator_t* Generator;
+
+unsigned long long nextRandom(unsigned long long* state);
+double nextUniform(unsigned long long* state);
+char randomChar(unsigned long long* state, Generator generator);
+void put(char c, Generator generator);
+void flush(Generator generator);
+void writeHeight(Generator generator);
+void writeWidth(Generator generator);
+
+int main(int argc, char* argv[]){
+
+	generator_t generator;
+	int n;
+
+	if(argc < 3){
+		printf("Usage: %s height width [alphabet size] [mutation rate] [seed] [file]\n", argv[0]);
+		exit(1);
+	}
+	generator.height = atoll(argv[1]);
+	generator.width = atoll(argv[2]);
+	generator.alphabetSize = (argc > 3) ? atoi(argv[3]) : 4;
+	generator.mutation = (argc > 4) ? atof(argv[4]) : 0.1;
+	generator.seed = (argc > 5) ? strtoull(argv[5], NULL, 10) : 1;
+	if(generator.height < 0 || generator.width < 0 ||
+	   generator.alphabetSize < 1 || generator.alphabetSize > MAX_ALPHABET ||
+	   generator.mutation < 0 || generator.mutation > 1){
+		printf("Sizes must be >= 0, the alphabet 1 to %d characters, the mutation rate 0 to 1\n", MAX_ALPHABET);
+		exit(1);
+	}
+	if(generator.alphabetSize == 4){
+		strcpy(generator.alphabet, "ACGT");
+	}else{
+		for(n = 0; n < generator.alphabetSize; n++){
+			generator.alphabet[n] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789"[n];
+		}
+		generator.alphabet[n] = '\0';
+	}
+	if(argc > 6){
+		if(!(generator.file = fopen(argv[6], "w"))){
+			printf("Error opening file \"%s\"\n", argv[6]);
+			exit(2);
+		}
+	}else{
+		generator.file = stdout;
+	}
+	generator.buffer = (char*)malloc(BUFFER_SIZE);
+	generator.used = 0;
+
+	fprintf(generator.file, "%lld %lld\n", generator.height, generator.width);
+	writeHeight(&generator);
+	writeWidth(&generator);
+	flush(&generator);
+
+	free(generator.buffer);
+	if(generator.file != stdout) fclose(generator.file);
+	return 0;
+}
+
+/* splitmix64, small and good enough to make inputs reproducible
+ */
+unsigned long long nextRandom(unsigned long long* state){
+	unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+double nextUniform(unsigned long long* state){
+	return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+char randomChar(unsigned long long* state, Generator generator){
+	return generator->alphabet[nextRandom(state) % generator->alphabetSize];
+}
+
+/* Functions that buffer the output so multi-GB inputs are written
+ * in large blocks, without ever holding a sequence in memory
+ */
+void put(char c, Generator generator){
+	if(generator->used == BUFFER_SIZE) flush(generator);
+	generator->buffer[generator->used++] = c;
+}
+
+void flush(Generator generator){
+	if(generator->used > 0 && fwrite(generator->buffer, 1, generator->used, generator->file) != generator->used){
+		printf("Error writing the input\n");
+		exit(2);
+	}
+	generator->used = 0;
+}
+
+/* Writes the vertical sequence, uniform over the alphabet
+ */
+void writeHeight(Generator generator){
+	unsigned long long state = generator->seed;
+	long long n;
+
+	for(n = 0; n < generator->height; n++){
+		put(randomChar(&state, generator), generator);
+	}
+	put('\n', generator);
+}
+
+/* Writes the horizontal sequence, derived from the vertical one
+ * The vertical sequence is replayed from the seed and stretched to width:
+ * with a shorter width characters are dropped, with a longer one random
+ * characters are inserted, and each kept character is replaced with the
+ * mutation rate, so similarity goes from 1 - mutation down to random
+ */
+void writeWidth(Generator generator){
+	unsigned long long base = generator->seed;
+	unsigned long long state = generator->seed ^ 0x5DEECE66DULL;
+	double ratio = generator->height ? (double)generator->width / generator->height : 0;
+	double owed = 0;
+	long long written = 0, n;
+	char c;
+
+	for(n = 0; n < generator->height && written < generator->width; n++){
+		c = randomChar(&base, generator);
+		owed += ratio;
+		if(owed < 1) continue;
+		if(nextUniform(&state) < generator->mutation) c = randomChar(&state, generator);
+		put(c, generator);
+		written++;
+		owed -= 1;
+		while(owed >= 1 && written < generator->width){
+			put(randomChar(&state, generator), generator);
+			written++;
+			owed -= 1;
+		}
+	}
+	while(written < generator->width){
+		put(randomChar(&state, generator), generator);
+		written++;
+	}
+	put('\n', generator);
+}
@@ -0,0 +1,396 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define MAX(x, y) ( ((x) > (y)) ? (x) : (y) )
+
+#define CUTOFF 64
+#define STATE_MAGIC "LCSINC01"
+
+#define DIAGONAL 0
+#define LEFT 1
+#define UP 2
+
+/* Incremental board: vectorHeight is fixed, vectorWidth only grows
+ * The state keeps the last column of the matrix, and on disk the
+ * backtrack move of every cell, one column of 2-bit moves per symbol
+ * of vectorWidth; the backtrack takes its characters from vectorHeight,
+ * so the appended symbols themselves are not kept
+ * Appending c symbols fills an height x c block, O(height * c)
+ */
+typedef struct {
+	int height;
+	int width;
+	char* vectorHeight;
+	short* lastColumn;	//column width, rows 0..height
+	char* stateName;
+}board_t;
+
+typedef struct {
+	char magic[8];
+	int height;
+	int width;
+}state_header_t;
+
+typedef board_t* Board;
+
+short cost(int x);
+Board initBoard(char* stateName, char* fileName);
+Board loadBoard(char* stateName);
+void saveBoard(Board board);
+char* readSymbols(FILE* file, int* length);
+void processCell(int i, int k, int j, char symbol, short** block, Board board);
+void fillBlock(int i0, int i1, int k0, int k1, int width, char* symbols, short** block, Board board);
+void appendSymbols(Board board, char* symbols, int length);
+void printResults(board_t* board);
+void cleanAll(board_t* board);
+FILE* openPart(Board board, char* suffix, char* mode);
+
+int main(int argc, char* argv[]){
+
+	Board board;
+	FILE* file;
+	char* symbols;
+	int length;
+
+	if(argc < 3 || (strcmp(argv[1], "print") && argc < 4)){
+		printf("Usage: %s init state file.in | append state symbols.txt | print state\n", argv[0]);
+		exit(1);
+	}
+	if(!strcmp(argv[1], "init")){
+		board = initBoard(argv[2], argv[3]);
+		printf("%d\n", board->lastColumn[board->height]);
+	}else if(!strcmp(argv[1], "append")){
+		board = loadBoard(argv[2]);
+		if(!(file = fopen(argv[3], "r"))){
+			printf("Error opening file \"%s\"\n", argv[3]);
+			exit(2);
+		}
+		symbols = readSymbols(file, &length);
+		fclose(file);
+		appendSymbols(board, symbols, length);
+		free(symbols);
+		printf("%d\n", board->lastColumn[board->height]);
+	}else if(!strcmp(argv[1], "print")){
+		board = loadBoard(argv[2]);
+		printResults(board);
+	}else{
+		printf("Unknown command \"%s\"\n", argv[1]);
+		exit(1);
+	}
+	cleanAll(board);
+	return 0;
+}
+
+/* Opens one of the files of the state, named after it with a suffix
+ * returns the file
+ */
+FILE* openPart(Board board, char* suffix, char* mode){
+	char path[4096];
+	FILE* file;
+
+	snprintf(path, sizeof(path), "%s%s", board->stateName, suffix);
+	if(!(file = fopen(path, mode))){
+		printf("Error opening file \"%s\"\n", path);
+		exit(2);
+	}
+	return file;
+}
+
+/* Reads one line of symbols
+ * file, where to read; length, the number of symbols read
+ * returns the symbols, 1-based like vectorWidth
+ */
+char* readSymbols(FILE* file, int* length){
+	int size = 1024;
+	char* symbols = (char*)malloc(size);
+	int c, n = 1;
+
+	while((c = fgetc(file)) != '\n' && c != EOF){
+		if(n == size){
+			size *= 2;
+			symbols = (char*)realloc(symbols, size);
+		}
+		symbols[n++] = (char)c;
+	}
+	symbols[0] = '/';
+	*length = n - 1;
+	return symbols;
+}
+
+/* Function that builds a state from an input file
+ * Starts from an empty vectorWidth and appends the whole second sequence
+ * stateName, the state to create; fileName, the name of the file to be read
+ * returns the board
+ */
+Board initBoard(char* stateName, char* fileName){
+	FILE* file;
+	int height;
+	int width;
+	int c, length;
+	char* vectorHeight;
+	char* vectorWidth;
+	size_t n = 1;
+
+	if (!(file = fopen(fileName,"r"))){
+	    printf("Error opening file \"%s\"\n", fileName);
+	    exit(2);
+	}
+	if(fscanf(file, "%d %d\n", &height, &width) != 2){
+	    printf("Could not read height and width");
+	    exit(3);
+	}
+	if(!(vectorHeight = (char*) malloc(sizeof(char)*(height + 1)))){
+		    printf("Error allocating row pointers for board.\n");
+		    exit(4);
+	}
+	while((c = fgetc(file)) != '\n'){
+		 vectorHeight[n++] = (char)c;
+	}
+	vectorHeight[0] = '/';
+	vectorWidth = readSymbols(file, &length);
+	fclose(file);
+	file = NULL;
+
+	Board result = (Board)malloc(sizeof(board_t));
+
+	result->height = height;
+	result->width = 0;
+	result->vectorHeight = vectorHeight;
+	result->lastColumn = (short*)calloc(height + 1, sizeof(short));
+	result->stateName = stateName;
+
+	fclose(openPart(result, ".dir", "wb"));
+	appendSymbols(result, vectorWidth, length);
+	free(vectorWidth);
+	return result;
+}
+
+/* Function that reads a state written by saveBoard
+ * stateName, the state to read
+ * returns the board
+ */
+Board loadBoard(char* stateName){
+	state_header_t header;
+	Board result = (Board)malloc(sizeof(board_t));
+	FILE* file;
+
+	result->stateName = stateName;
+	file = openPart(result, "", "rb");
+	if(fread(&header, sizeof(header), 1, file) != 1 ||
+	   memcmp(header.magic, STATE_MAGIC, sizeof(header.magic))){
+		printf("\"%s\" is not an incremental state\n", stateName);
+		exit(3);
+	}
+	result->height = header.height;
+	result->width = header.width;
+	result->vectorHeight = (char*)malloc(sizeof(char) * (header.height + 1));
+	result->lastColumn = (short*)malloc(sizeof(short) * (header.height + 1));
+	if(fread(result->vectorHeight, sizeof(char), header.height + 1, file) != header.height + 1 ||
+	   fread(result->lastColumn, sizeof(short), header.height + 1, file) != header.height + 1){
+		printf("State \"%s\" is truncated\n", stateName);
+		exit(3);
+	}
+	fclose(file);
+	return result;
+}
+
+/* Function that writes the header, vectorHeight and the last column
+ * The moves are appended first, so renaming the new header
+ * into place commits the append
+ */
+void saveBoard(Board board){
+	state_header_t header;
+	char path[4096];
+	char tmpPath[4096];
+	FILE* file;
+
+	memcpy(header.magic, STATE_MAGIC, sizeof(header.magic));
+	header.height = board->height;
+	header.width = board->width;
+	file = openPart(board, ".tmp", "wb");
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(board->vectorHeight, sizeof(char), board->height + 1, file);
+	fwrite(board->lastColumn, sizeof(short), board->height + 1, file);
+	fclose(file);
+	snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", board->stateName);
+	snprintf(path, sizeof(path), "%s", board->stateName);
+	rename(tmpPath, path);
+}
+
+/* Function that applies the given algorithm to one cell of the block
+ * Column 0 of the block is the last column of the matrix
+ * i, the line; k, the block column; j, the matrix column; symbol, vectorWidth[j]
+ */
+void processCell(int i, int k, int j, char symbol, short** block, Board board){
+	if (i == 0) {
+		block[i][k] = 0;
+	} else if (board->vectorHeight[i] == symbol) {
+		block[i][k] = block[i - 1][k - 1] + cost(i+j);
+	}else{
+		block[i][k] = MAX(block[i - 1][k], block[i][k - 1]);
+	}
+}
+
+/* Cache-oblivious fill of the block, as the recursive fill of lcs-omp
+ * The top right and bottom left quadrants run as tasks when built with OpenMP
+ * width, the matrix column of block column 0
+ */
+void fillBlock(int i0, int i1, int k0, int k1, int width, char* symbols, short** block, Board board){
+	int im = (i0 + i1) / 2;
+	int km = (k0 + k1) / 2;
+	int i, k;
+
+	if (i1 - i0 < CUTOFF && k1 - k0 < CUTOFF) {
+		for (i = i0; i <= i1; ++i) {
+			for (k = k0; k <= k1; ++k) {
+				processCell(i, k, width + k, symbols[k], block, board);
+			}
+		}
+	} else if (i1 - i0 < CUTOFF) {
+		fillBlock(i0, i1, k0, km, width, symbols, block, board);
+		fillBlock(i0, i1, km + 1, k1, width, symbols, block, board);
+	} else if (k1 - k0 < CUTOFF) {
+		fillBlock(i0, im, k0, k1, width, symbols, block, board);
+		fillBlock(im + 1, i1, k0, k1, width, symbols, block, board);
+	} else {
+		fillBlock(i0, im, k0, km, width, symbols, block, board);
+#pragma omp task
+		fillBlock(i0, im, km + 1, k1, width, symbols, block, board);
+		fillBlock(im + 1, i1, k0, km, width, symbols, block, board);
+#pragma omp taskwait
+		fillBlock(im + 1, i1, km + 1, k1, width, symbols, block, board);
+	}
+}
+
+/* Function that appends symbols to vectorWidth
+ * Fills the height x length block right of the last column, stores the
+ * backtrack move of each new cell with the printResults rules (the cell
+ * value stands for the running length, as in the directions engine of
+ * lcs-serial) and keeps the new last column
+ * symbols, 1-based; length, how many
+ */
+void appendSymbols(Board board, char* symbols, int length){
+	int height = board->height;
+	int columnBytes = (height + 3) / 4;
+	unsigned char* moves;
+	short** block;
+	short value;
+	int i, k, direction;
+	FILE* dirFile;
+
+	if(length == 0){
+		saveBoard(board);
+		return;
+	}
+	block = (short**)malloc(sizeof(short*) * (height + 1));
+	for(i = 0; i <= height; i++){
+		if(!(block[i] = (short*)malloc(sizeof(short) * (length + 1)))){
+			printf("Error allocating block.\n");
+			exit(4);
+		}
+		block[i][0] = board->lastColumn[i];
+	}
+#pragma omp parallel
+#pragma omp single
+	fillBlock(0, height, 1, length, board->width, symbols, block, board);
+
+	moves = (unsigned char*)malloc(columnBytes);
+	dirFile = openPart(board, ".dir", "r+b");
+	fseek(dirFile, (long)board->width * columnBytes, SEEK_SET);
+	for(k = 1; k <= length; k++){
+		memset(moves, 0, columnBytes);
+		for(i = 1; i <= height; i++){
+			value = block[i][k];
+			if ((block[i - 1][k] != value) && (block[i][k - 1] != value)) {
+				direction = DIAGONAL;
+			} else if (board->vectorHeight[i] == symbols[k]) {
+				direction = DIAGONAL;
+			} else if (block[i][k - 1] == value) {
+				direction = LEFT;
+			} else {
+				direction = UP;
+			}
+			moves[(i - 1) / 4] |= direction << (2 * ((i - 1) % 4));
+		}
+		fwrite(moves, 1, columnBytes, dirFile);
+	}
+	fclose(dirFile);
+
+	for(i = 0; i <= height; i++){
+		board->lastColumn[i] = block[i][length];
+		free(block[i]);
+	}
+	free(block);
+	free(moves);
+	board->width += length;
+	saveBoard(board);
+}
+
+/* Function that backtracks the stored moves and fills the subsequence
+ * Reads one column of moves each time the path goes left
+ * Prints out the final output
+ * board, the current board
+ */
+void printResults(board_t* board){
+	int heightLength = board->height;
+	int widthLength = board->width;
+	int columnBytes = (board->height + 3) / 4;
+	int aux, finalSize = board->lastColumn[board->height];
+	int loaded = -1, direction;
+	char* subsequence = (char*) malloc(sizeof(char) * (finalSize + 1));
+	unsigned char* moves = (unsigned char*)malloc(columnBytes);
+	FILE* dirFile = openPart(board, ".dir", "rb");
+
+	aux = finalSize;
+	while(aux > 0){
+		if(loaded != widthLength){
+			if(fseek(dirFile, (long)(widthLength - 1) * columnBytes, SEEK_SET) ||
+			   fread(moves, 1, columnBytes, dirFile) != columnBytes){
+				printf("State \"%s\" is truncated\n", board->stateName);
+				exit(3);
+			}
+			loaded = widthLength;
+		}
+		direction = (moves[(heightLength - 1) / 4] >> (2 * ((heightLength - 1) % 4))) & 3;
+		if(direction == DIAGONAL){
+			subsequence[aux -1] = board->vectorHeight[heightLength];
+			heightLength--;
+			widthLength--;
+			aux--;
+		}else if(direction == LEFT){
+			widthLength--;
+		}else{
+			heightLength--;
+		}
+	}
+	printf("%d\n", finalSize);
+	fwrite(subsequence, sizeof(char), finalSize, stdout);
+	printf("\n");
+
+	fclose(dirFile);
+	free(moves);
+	free(subsequence);
+}
+
+/* Function to add computation time
+ * returns 1 always
+ */
+short cost(int x){
+	int i, n_iter = 20;
+	double dcost = 0;
+	for(i = 0; i < n_iter; i++)
+		dcost += pow(sin((double) x),2) + pow(cos((double) x),2);
+	return (short) (dcost / n_iter + 0.1);
+}
+
+/*
+ * Clears the resourses used
+ */
+void cleanAll(board_t* board){
+
+	free(board->vectorHeight);
+	free(board->lastColumn);
+	free(board);
+}
@@ -0,0 +1,448 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <omp.h>
+
+#define MAX(x, y) ( ((x) > (y)) ? (x) : (y) )
+#define MIN(x, y) ( ((x) > (y)) ? (y) : (x) )
+
+#define WEIGHTED 0
+#define UNIT 1
+#define BYTES 0
+#define DNA 1
+#define LENGTH 0
+#define TRACEBACK 1
+
+typedef struct {
+	int height;
+	int width;
+	char* vectorHeight;
+	char* vectorWidth;
+	unsigned char* codesHeight;	//0..3 for ACGT, only when dna
+	unsigned char* profile[4];	//profile[code][j], 1 where vectorWidth[j] has that code
+	short* costTable;		//cost(i + j)
+	short maxCost;
+	short unitCost;			//1 when every cost(i + j) is 1
+	short dna;			//1 when both sequences only use ACGT
+	size_t budget;			//LCS_MEM_BUDGET, a traceback matrix must fit in it
+	char* subsequence;
+	int size;
+}board_t;
+
+typedef board_t* Board;
+
+typedef long (*kernel_f)(Board board);
+
+typedef struct {
+	char* name;
+	int cellBytes;
+	short cost;		//WEIGHTED or UNIT
+	short alphabet;		//BYTES or DNA
+	short mode;		//LENGTH or TRACEBACK
+	kernel_f kernel;
+}kernel_t;
+
+short cost(int x);
+Board parseFile(char* fileName);
+size_t memoryBudget();
+size_t kernelMemory(int cellBytes, short mode, Board board);
+int fits(kernel_t* kernel, Board board);
+kernel_t* chooseKernel(short mode, Board board);
+void benchmark(short mode, Board board);
+void printResults(board_t* board, long value, short mode);
+void cleanAll(board_t* board);
+
+/* The kernel family
+ * Every kernel is the recurrence of lcs-serial with the choices fixed at
+ * compile time: the cell type, unit or table cost, a char compare or the
+ * DNA profile row, and a full matrix with the lcs-serial traceback or two
+ * rows for the length only; the constant branches fold away
+ * returns the LCS, the subsequence is left in the board with TRACEBACK
+ */
+#define DEFINE_KERNEL(NAME, CELL, COST, ALPHABET, MODE)					\
+long NAME(Board board){									\
+	int height = board->height, width = board->width;				\
+	size_t columns = (size_t)width + 1;						\
+	CELL* cells = (CELL*)calloc((MODE == TRACEBACK) ? (height + 1) * columns : 2 * columns, sizeof(CELL)); \
+	CELL *previous = cells, *current;						\
+	CELL up, left, diag, value;							\
+	unsigned char* profile = NULL;							\
+	char letter = 0;								\
+	long result;									\
+	int i, j, match;								\
+											\
+	if (cells == NULL) {								\
+		printf("Error allocating row pointers for board.\n");			\
+		exit(4);								\
+	}										\
+	for (i = 1; i <= height; i++) {							\
+		current = (MODE == TRACEBACK) ? previous + columns : cells + (i % 2) * columns; \
+		if (ALPHABET == DNA) profile = board->profile[board->codesHeight[i]];	\
+		else letter = board->vectorHeight[i];					\
+		diag = 0;								\
+		left = 0;								\
+		current[0] = 0;								\
+		for (j = 1; j <= width; j++) {						\
+			match = (ALPHABET == DNA) ? profile[j] : (letter == board->vectorWidth[j]); \
+			up = previous[j];						\
+			if (COST == UNIT) value = MAX(MAX(up, left), diag + match);	\
+			else value = match ? diag + board->costTable[i + j] : MAX(up, left); \
+			diag = up;							\
+			current[j] = left = value;					\
+		}									\
+		previous = current;							\
+	}										\
+	result = previous[width];							\
+	if (MODE == TRACEBACK) {							\
+		int aux = (int)result;							\
+		CELL* row;								\
+		board->subsequence = (char*)malloc(sizeof(char) * (result + 1));	\
+		board->size = (int)result;						\
+		i = height;								\
+		j = width;								\
+		while (aux > 0) {							\
+			row = cells + i * columns;					\
+			if ((row[j - columns] != aux) && (row[j - 1] != aux)) {		\
+				board->subsequence[--aux] = board->vectorHeight[i--];	\
+				j--;							\
+			} else if (board->vectorHeight[i] == board->vectorWidth[j]) {	\
+				board->subsequence[--aux] = board->vectorHeight[i--];	\
+				j--;							\
+			} else if (row[j - 1] == aux) {					\
+				j--;							\
+			} else if (row[j - columns] == aux) {				\
+				i--;							\
+			}								\
+		}									\
+	}										\
+	free(cells);									\
+	return result;									\
+}
+
+/* The reference of the benchmark is the kernel lcs-serial would be: short
+ * cells, the cost table and a char compare, in the same mode as the others
+ */
+DEFINE_KERNEL(kernelGenericLength, short, WEIGHTED, BYTES, LENGTH)
+DEFINE_KERNEL(kernelGenericTraceback, short, WEIGHTED, BYTES, TRACEBACK)
+
+DEFINE_KERNEL(kernel8UnitDnaLength, uint8_t, UNIT, DNA, LENGTH)
+DEFINE_KERNEL(kernel8UnitBytesLength, uint8_t, UNIT, BYTES, LENGTH)
+DEFINE_KERNEL(kernel8WeightedDnaLength, uint8_t, WEIGHTED, DNA, LENGTH)
+DEFINE_KERNEL(kernel8WeightedBytesLength, uint8_t, WEIGHTED, BYTES, LENGTH)
+DEFINE_KERNEL(kernel16UnitDnaLength, uint16_t, UNIT, DNA, LENGTH)
+DEFINE_KERNEL(kernel16UnitBytesLength, uint16_t, UNIT, BYTES, LENGTH)
+DEFINE_KERNEL(kernel16WeightedDnaLength, uint16_t, WEIGHTED, DNA, LENGTH)
+DEFINE_KERNEL(kernel16WeightedBytesLength, uint16_t, WEIGHTED, BYTES, LENGTH)
+DEFINE_KERNEL(kernel32UnitDnaLength, uint32_t, UNIT, DNA, LENGTH)
+DEFINE_KERNEL(kernel32UnitBytesLength, uint32_t, UNIT, BYTES, LENGTH)
+DEFINE_KERNEL(kernel32WeightedDnaLength, uint32_t, WEIGHTED, DNA, LENGTH)
+DEFINE_KERNEL(kernel32WeightedBytesLength, uint32_t, WEIGHTED, BYTES, LENGTH)
+DEFINE_KERNEL(kernel8UnitDnaTraceback, uint8_t, UNIT, DNA, TRACEBACK)
+DEFINE_KERNEL(kernel8UnitBytesTraceback, uint8_t, UNIT, BYTES, TRACEBACK)
+DEFINE_KERNEL(kernel8WeightedDnaTraceback, uint8_t, WEIGHTED, DNA, TRACEBACK)
+DEFINE_KERNEL(kernel8WeightedBytesTraceback, uint8_t, WEIGHTED, BYTES, TRACEBACK)
+DEFINE_KERNEL(kernel16UnitDnaTraceback, uint16_t, UNIT, DNA, TRACEBACK)
+DEFINE_KERNEL(kernel16UnitBytesTraceback, uint16_t, UNIT, BYTES, TRACEBACK)
+DEFINE_KERNEL(kernel16WeightedDnaTraceback, uint16_t, WEIGHTED, DNA, TRACEBACK)
+DEFINE_KERNEL(kernel16WeightedBytesTraceback, uint16_t, WEIGHTED, BYTES, TRACEBACK)
+DEFINE_KERNEL(kernel32UnitDnaTraceback, uint32_t, UNIT, DNA, TRACEBACK)
+DEFINE_KERNEL(kernel32UnitBytesTraceback, uint32_t, UNIT, BYTES, TRACEBACK)
+DEFINE_KERNEL(kernel32WeightedDnaTraceback, uint32_t, WEIGHTED, DNA, TRACEBACK)
+DEFINE_KERNEL(kernel32WeightedBytesTraceback, uint32_t, WEIGHTED, BYTES, TRACEBACK)
+
+/* Dispatch table, in order of preference: the first kernel that fits wins
+ * Length only kernels keep two rows, so 32-bit cells cost nothing in memory
+ * and avoid the partial register updates of narrow ones; traceback kernels
+ * are bound by the matrix and prefer the narrowest cell that fits
+ * The DNA profile only paid off for the unit length kernels (about 30% at
+ * 32 bits on ex48k.30k, even at 16), with the cost table or the full matrix
+ * it measured slower than the char compare, so those rank after it
+ */
+kernel_t kernels[] = {
+	{"32-bit unit dna length", 4, UNIT, DNA, LENGTH, kernel32UnitDnaLength},
+	{"32-bit unit bytes length", 4, UNIT, BYTES, LENGTH, kernel32UnitBytesLength},
+	{"32-bit weighted bytes length", 4, WEIGHTED, BYTES, LENGTH, kernel32WeightedBytesLength},
+	{"32-bit weighted dna length", 4, WEIGHTED, DNA, LENGTH, kernel32WeightedDnaLength},
+	{"16-bit unit dna length", 2, UNIT, DNA, LENGTH, kernel16UnitDnaLength},
+	{"16-bit unit bytes length", 2, UNIT, BYTES, LENGTH, kernel16UnitBytesLength},
+	{"16-bit weighted bytes length", 2, WEIGHTED, BYTES, LENGTH, kernel16WeightedBytesLength},
+	{"16-bit weighted dna length", 2, WEIGHTED, DNA, LENGTH, kernel16WeightedDnaLength},
+	{"8-bit unit dna length", 1, UNIT, DNA, LENGTH, kernel8UnitDnaLength},
+	{"8-bit unit bytes length", 1, UNIT, BYTES, LENGTH, kernel8UnitBytesLength},
+	{"8-bit weighted bytes length", 1, WEIGHTED, BYTES, LENGTH, kernel8WeightedBytesLength},
+	{"8-bit weighted dna length", 1, WEIGHTED, DNA, LENGTH, kernel8WeightedDnaLength},
+	{"8-bit unit bytes traceback", 1, UNIT, BYTES, TRACEBACK, kernel8UnitBytesTraceback},
+	{"8-bit unit dna traceback", 1, UNIT, DNA, TRACEBACK, kernel8UnitDnaTraceback},
+	{"8-bit weighted bytes traceback", 1, WEIGHTED, BYTES, TRACEBACK, kernel8WeightedBytesTraceback},
+	{"8-bit weighted dna traceback", 1, WEIGHTED, DNA, TRACEBACK, kernel8WeightedDnaTraceback},
+	{"16-bit unit bytes traceback", 2, UNIT, BYTES, TRACEBACK, kernel16UnitBytesTraceback},
+	{"16-bit unit dna traceback", 2, UNIT, DNA, TRACEBACK, kernel16UnitDnaTraceback},
+	{"16-bit weighted bytes traceback", 2, WEIGHTED, BYTES, TRACEBACK, kernel16WeightedBytesTraceback},
+	{"16-bit weighted dna traceback", 2, WEIGHTED, DNA, TRACEBACK, kernel16WeightedDnaTraceback},
+	{"32-bit unit bytes traceback", 4, UNIT, BYTES, TRACEBACK, kernel32UnitBytesTraceback},
+	{"32-bit unit dna traceback", 4, UNIT, DNA, TRACEBACK, kernel32UnitDnaTraceback},
+	{"32-bit weighted bytes traceback", 4, WEIGHTED, BYTES, TRACEBACK, kernel32WeightedBytesTraceback},
+	{"32-bit weighted dna traceback", 4, WEIGHTED, DNA, TRACEBACK, kernel32WeightedDnaTraceback},
+};
+
+#define NUM_KERNELS ((int)(sizeof(kernels) / sizeof(kernels[0])))
+
+int main(int argc, char* argv[]){
+
+	short mode = TRACEBACK;
+	int bench = 0, n;
+	char* fileName = NULL;
+	kernel_t* kernel;
+	long value;
+
+	for(n = 1; n < argc; n++){
+		if(!strcmp(argv[n], "-l")) mode = LENGTH;
+		else if(!strcmp(argv[n], "-b")) bench = 1;
+		else fileName = argv[n];
+	}
+	if(fileName == NULL){
+		printf("Usage: %s file.in [-l] [-b]\n", argv[0]);
+		exit(1);
+	}
+	Board board = parseFile(fileName);
+	if(bench){
+		benchmark(mode, board);
+	}else{
+		kernel = chooseKernel(mode, board);
+		fprintf(stderr, "kernel: %s\n", kernel->name);
+		value = kernel->kernel(board);
+		printResults(board, value, mode);
+	}
+	cleanAll(board);
+	return 0;
+}
+
+/* Function that reads the memory budget
+ * LCS_MEM_BUDGET accepts a byte count with an optional K, M or G suffix
+ * returns the budget, the physical memory when it is not set
+ */
+size_t memoryBudget(){
+	char* value = getenv("LCS_MEM_BUDGET");
+	char* suffix;
+	double budget;
+
+	if (value == NULL || *value == '\0') {
+		return (size_t)sysconf(_SC_PHYS_PAGES) * (size_t)sysconf(_SC_PAGE_SIZE);
+	}
+	budget = strtod(value, &suffix);
+	switch (*suffix) {
+		case 'G': case 'g': budget *= 1024.0 * 1024 * 1024; break;
+		case 'M': case 'm': budget *= 1024.0 * 1024; break;
+		case 'K': case 'k': budget *= 1024.0; break;
+	}
+	return (size_t)budget;
+}
+
+/* Function that computes the cells a kernel allocates
+ * returns the bytes of the full matrix with TRACEBACK, of two rows otherwise
+ */
+size_t kernelMemory(int cellBytes, short mode, Board board){
+	size_t columns = (size_t)board->width + 1;
+
+	return (size_t)cellBytes * columns * ((mode == TRACEBACK) ? (size_t)board->height + 1 : 2);
+}
+
+/* Function that tells if a kernel can run this input exactly
+ * The cells must hold the largest possible value, unit kernels need
+ * cost() to be 1 everywhere and dna kernels need an ACGT only input
+ * returns 1 if it fits
+ */
+int fits(kernel_t* kernel, Board board){
+	long largest = (long)MIN(board->height, board->width) * board->maxCost;
+
+	if(kernel->cellBytes < 4 && largest >= (1L << (8 * kernel->cellBytes))) return 0;
+	if(kernel->cost == UNIT && !board->unitCost) return 0;
+	if(kernel->alphabet == DNA && !board->dna) return 0;
+	return 1;
+}
+
+/* Function that picks the first kernel of the table that fits, and whose
+ * cells fit the memory budget
+ * Exits when no traceback matrix fits, lcs-serial keeps 2-bit directions
+ * mode, LENGTH or TRACEBACK
+ * returns the kernel
+ */
+kernel_t* chooseKernel(short mode, Board board){
+	size_t memory, smallest = 0;
+	int n;
+
+	for(n = 0; n < NUM_KERNELS; n++){
+		if(kernels[n].mode != mode || !fits(&kernels[n], board)) continue;
+		memory = kernelMemory(kernels[n].cellBytes, mode, board);
+		if(memory <= board->budget) return &kernels[n];
+		if(smallest == 0 || memory < smallest) smallest = memory;
+	}
+	fprintf(stderr, "plan: no kernel fits, smallest matrix %zu bytes, budget %zu bytes, use lcs-serial\n",
+	        smallest, board->budget);
+	exit(5);
+}
+
+/* Runs the generic recurrence and every kernel that fits the input in the
+ * same mode, checks they agree and prints the time and the gain of each one
+ * With TRACEBACK the subsequences must match too
+ * mode, LENGTH or TRACEBACK
+ */
+void benchmark(short mode, Board board){
+	double start, reference, seconds;
+	long expected, value;
+	char* subsequence;
+	int n, same;
+
+	if(kernelMemory(sizeof(short), mode, board) > board->budget){
+		fprintf(stderr, "plan: the generic matrix takes %zu bytes, budget %zu bytes\n",
+		        kernelMemory(sizeof(short), mode, board), board->budget);
+		exit(5);
+	}
+	start = omp_get_wtime();
+	expected = (mode == TRACEBACK) ? kernelGenericTraceback(board) : kernelGenericLength(board);
+	reference = omp_get_wtime() - start;
+	subsequence = board->subsequence;
+	board->subsequence = NULL;
+	printf("%-32s %10s %8s\n", "kernel", "seconds", "speedup");
+	printf("%-32s %10.3f %8.2f\n", "generic", reference, 1.0);
+	for(n = 0; n < NUM_KERNELS; n++){
+		if(kernels[n].mode != mode || !fits(&kernels[n], board)) continue;
+		if(kernelMemory(kernels[n].cellBytes, mode, board) > board->budget) continue;
+		start = omp_get_wtime();
+		value = kernels[n].kernel(board);
+		seconds = omp_get_wtime() - start;
+		same = (value == expected);
+		if(mode == TRACEBACK) same = same && !memcmp(board->subsequence, subsequence, expected);
+		free(board->subsequence);
+		board->subsequence = NULL;
+		printf("%-32s %10.3f %8.2f%s\n", kernels[n].name, seconds, reference / seconds,
+		       same ? "" : "  WRONG");
+	}
+	free(subsequence);
+	printf("chosen: %s\n", chooseKernel(mode, board)->name);
+}
+
+/* Function that reads the file and builds the board
+ * Builds the vertical and horizontal string, the cost table and,
+ * for ACGT inputs, the codes and profile rows of the dna kernels
+ * filename, the name of the file to be read
+ * returns the board
+ */
+Board parseFile(char* fileName){
+	FILE* file;
+	int height;
+	int width;
+	int c;
+	char* vectorHeight;
+	char* vectorWeidth;
+	unsigned char code[256];
+	size_t n = 1;
+
+	if (!(file = fopen(fileName,"r"))){
+	    printf("Error opening file \"%s\"\n", fileName);
+	    exit(2);
+	}
+	if(fscanf(file, "%d %d\n", &height, &width) == 0){
+	    printf("Could not read height and width");
+	    exit(3);
+	}
+	if(!(vectorHeight = (char*) malloc(sizeof(char)*(height + 1)))||
+	   !(vectorWeidth = (char*) malloc(sizeof(char)*(width + 1)))){
+		    printf("Error allocating row pointers for board.\n");
+		    exit(4);
+	}
+
+	while((c = fgetc(file)) != '\n' && c != EOF){
+		 vectorHeight[n++] = (char)c;
+	}
+	vectorHeight[0] = '/';
+
+	n = 1;
+	while((c = fgetc(file)) != '\n' && c != EOF){
+		vectorWeidth[n++] = (char)c;
+	}
+	vectorWeidth[0] = '/';
+	fclose(file);
+	file = NULL;
+
+	Board result = (Board)malloc(sizeof(board_t));
+
+	result->height = height;
+	result->width = width;
+	result->vectorHeight = vectorHeight;
+	result->vectorWidth = vectorWeidth;
+	result->subsequence = NULL;
+	result->size = 0;
+	result->budget = memoryBudget();
+	result->costTable = (short*)malloc(sizeof(short) * (height + width + 1));
+	result->maxCost = 0;
+	result->unitCost = 1;
+	for(n = 0; n < height + width + 1; n++){
+		result->costTable[n] = cost(n);
+		if(n >= 2){
+			result->maxCost = MAX(result->maxCost, result->costTable[n]);
+			if(result->costTable[n] != 1) result->unitCost = 0;
+		}
+	}
+
+	memset(code, 4, sizeof(code));
+	code['A'] = 0; code['C'] = 1; code['G'] = 2; code['T'] = 3;
+	result->dna = 1;
+	for(n = 1; n <= height && result->dna; n++) result->dna = code[(unsigned char)vectorHeight[n]] < 4;
+	for(n = 1; n <= width && result->dna; n++) result->dna = code[(unsigned char)vectorWeidth[n]] < 4;
+	result->codesHeight = NULL;
+	for(c = 0; c < 4; c++) result->profile[c] = NULL;
+	if(result->dna){
+		result->codesHeight = (unsigned char*)malloc(height + 1);
+		for(n = 1; n <= height; n++) result->codesHeight[n] = code[(unsigned char)vectorHeight[n]];
+		for(c = 0; c < 4; c++){
+			result->profile[c] = (unsigned char*)calloc(width + 1, 1);
+			for(n = 1; n <= width; n++) result->profile[c][n] = (code[(unsigned char)vectorWeidth[n]] == c);
+		}
+	}
+
+	return result;
+}
+
+/* Prints the result of the LCS, and the subsequence after a traceback
+ */
+void printResults(board_t* board, long value, short mode){
+	int n;
+
+	printf("%ld\n", value);
+	if(mode == TRACEBACK){
+		for (n = 0; n < board->size; ++n) {
+			printf("%c", board->subsequence[n]);
+		}
+		printf("\n");
+	}
+}
+
+/* Function to add computation time
+ * returns 1 always
+ */
+short cost(int x){
+	int i, n_iter = 20;
+	double dcost = 0;
+	for(i = 0; i < n_iter; i++)
+		dcost += pow(sin((double) x),2) + pow(cos((double) x),2);
+	return (short) (dcost / n_iter + 0.1);
+}
+
+/*
+ * Clears the resourses used
+ */
+void cleanAll(board_t* board){
+	int c;
+
+	free(board->vectorHeight);
+	free(board->vectorWidth);
+	free(board->costTable);
+	free(board->codesHeight);
+	for(c = 0; c < 4; c++) free(board->profile[c]);
+	free(board->subsequence);
+	free(board);
+}
@@ -3,6 +3,9 @@
 #include <math.h>
 #include <mpi.h>
 #include <omp.h>
+#include <unistd.h>
+#include <string.h>
+#include <pthread.h>
 
 #define MAX(x, y) ( ((x) > (y)) ? (x) : (y) )
 #define MIN(x, y) ( ((x) > (y)) ? (y) : (x) )
@@ -20,6 +23,23 @@
 
 #define ROOT 0;
 
+#define HEADER_BYTES 64
+#define CHECKPOINT_SAVED ((void*)1)	//what the writer thread returns when the lines are safe
+
+#define CHECKPOINT_EVERY 1024
+#define CHECKPOINT_MAGIC "LCSCKPT1"
+
+
+typedef struct {
+	MPI_Comm nodeComm;	//ranks sharing memory with this one
+	MPI_Comm leaderComm;	//one rank per node, MPI_COMM_NULL on the others
+	int nodeRank;
+	int nodeSize;
+	int node;		//index of the node among the leaders
+	int numNodes;
+	int workRank;		//block of the anti-diagonals, numbered node by node
+	int* firstWork;		//first workRank of each node, numNodes + 1 entries
+}node_t;
 
 typedef struct {
 	int height;
@@ -29,11 +49,30 @@ typedef struct {
 	short CHANGE; 	//1 if it was not changed, otherwise 0
 	char* vectorHeight;
 	char* vectorWidth;
-	short** matrix;
+	short** matrix;		//only on rank 0
 	short numProc;
 	short rank;
+	node_t node;
+	MPI_Win sequenceWindow;	//both sequences, shared by the node
+	MPI_Win ringWindow;
+	short* ring;		//last three anti-diagonals, shared by the node
+	int firstLine;		//first anti-diagonal to compute, after a restart
+	char* checkpointDir;	//NULL when checkpoints are off
+	int checkpointEvery;
+	int checkpointedLines;	//lines already handed to the writer
+	int writeTo;		//lines the running writer will have saved
+	short writing;		//1 while the writer thread runs
+	pthread_t writer;
 }board_t;
 
+typedef struct {
+	char magic[8];
+	int height;
+	int width;
+	short CHANGE;
+	unsigned long hash;
+}checkpoint_header_t;
+
 
 typedef board_t* Board;
 
@@ -47,7 +86,23 @@ int getI(int line, int index, int height);
 int getJ(int line, int index, int heigth);
 int getLength_Line(int line, int height, int width);
 void initMPI(int *argc, char ***argv, int *rank, int *numProc);
-void processSubLine(short* vector1LineAbove, short* vector2LineAbove, short* vectorToProcess, int vectorToProcessLength, int line, Board board);
+void processSubLine(short* vector1LineAbove, short* vector2LineAbove, short* vectorToProcess, int vectorToProcessLength, int firstIndex, int line, Board board);
+size_t memoryBudget();
+size_t peakMemory(int height, int width, int rank, int nodeSize);
+void planMemory(int height, int width, int rank, node_t* node);
+void readSequence(MPI_File file, MPI_Offset offset, int length, char* vector, MPI_Win window, node_t* node);
+MPI_Offset skipSpace(MPI_File file, MPI_Offset offset);
+void initNode(node_t* node, int rank);
+void* allocShared(MPI_Aint bytes, MPI_Win* window, node_t* node);
+void syncNode(MPI_Win window, node_t* node);
+void restoreRing(Board board);
+unsigned long hashInput(Board board);
+void checkpointPath(Board board, char* path, char* suffix);
+void initCheckpoint(Board board);
+int restoreCheckpoint(Board board);
+void checkpointLines(Board board, int lines);
+void* writeCheckpoint(void* arg);
+void finishCheckpoint(Board board);
 
 int main(int argc, char* argv[]){
 
@@ -57,9 +112,11 @@ int main(int argc, char* argv[]){
 	//start = MPI_Wtime();
 	initMPI(&argc, &argv, &rank, &numProc);
 	Board board = parseFile(fileName, rank, numProc);
+	initCheckpoint(board);
 	iterateBoard(board);
 	if(rank == 0){
 		printResults(board);
+		finishCheckpoint(board);
 	//	end = MPI_Wtime();
 	//	printf("time: %f\n", end-start);
 	}
@@ -76,7 +133,10 @@ void initMPI(int *argc, char ***argv, int *rank, int *numProc){
 }
 
 Board parseFile(char* fileName, int rank, int numProc){
-	FILE* file;
+	MPI_File file;
+	MPI_Status status;
+	char headerBuffer[HEADER_BYTES];
+	long long header[4];	//height, width and offsets of the two sequences
 	int height;
 	int width;
 	int c;
@@ -87,67 +147,73 @@ Board parseFile(char* fileName, int rank, int numProc){
 	int maxlenght_line, aux, matrixHeight;
 	int n = 1;
 	short CHANGE = NOT_CHANGED;
-
+	node_t node;
+	MPI_Win sequenceWindow, ringWindow;
+	short* ring;
+
+	initNode(&node, rank);
+	if(MPI_File_open(MPI_COMM_WORLD, fileName, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS){
+		if(rank == 0) printf("Error opening file \"%s\"\n", fileName);
+		MPI_Finalize();
+		exit(2);
+	}
+	/* like fscanf("%d %d\n"), any whitespace, \r or blank lines included,
+	 * may follow the header and the first sequence */
 	if(rank == 0){
-		if (!(file = fopen(fileName,"r"))){
-			printf("Error opening file \"%s\"\n", fileName);
-			exit(2);
-		}
-		if(fscanf(file, "%d %d\n", &height, &width) == 0){
-			printf("Could not read height and width");
-			exit(3);
-		}
-		if(!(vectorHeight = (char*) malloc(sizeof(char)*(height + 1)))||
-		   !(vectorWidth = (char*) malloc(sizeof(char)*(width + 1)))){
-				printf("Error allocating row pointers for board.\n");
-				exit(4);
-		}
-
-		matrixHeight = width + height + 1;
-
-		while((c = fgetc(file)) != '\n'){
-			 vectorHeight[n++] = (char)c;
-		}
-		vectorHeight[0] = '/';
-
-		n = 1;
-		while((c = fgetc(file)) != '\n'){
-			vectorWidth[n++] = (char)c;
-		}
-		vectorWidth[0] = '/';
-
-		if(height < width){
-			c = height;
-			height = width;
-			width = c;
-			vectorAux = vectorHeight;
-			vectorHeight = vectorWidth;
-			vectorWidth = vectorAux;
-			CHANGE = CHANGED;
+		MPI_File_read_at(file, 0, headerBuffer, HEADER_BYTES - 1, MPI_CHAR, &status);
+		MPI_Get_count(&status, MPI_CHAR, &c);
+		headerBuffer[c] = '\0';
+		if(sscanf(headerBuffer, "%d %d%n", &height, &width, &n) == 2){
+			header[0] = height;
+			header[1] = width;
+			header[2] = skipSpace(file, n);
+			header[3] = skipSpace(file, header[2] + height);
+		}else{
+			header[0] = -1;
 		}
-		fclose(file);
-		file = NULL;
 	}
-	MPI_Bcast(&height, 1, MPI_INT, 0, MPI_COMM_WORLD);
-	MPI_Bcast(&width, 1, MPI_INT, 0, MPI_COMM_WORLD);
-	if(rank != 0){
-		vectorHeight = (char*)malloc(sizeof(char)*(height + 1));
-		vectorWidth = (char*)malloc(sizeof(char)*(width + 1));
+	MPI_Bcast(header, 4, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+	if(header[0] < 0){
+		if(rank == 0) printf("Could not read height and width");
+		MPI_File_close(&file);
+		MPI_Finalize();
+		exit(3);
+	}
+	height = (int)header[0];
+	width = (int)header[1];
+	planMemory(MAX(height, width), MIN(height, width), rank, &node);
+	vectorHeight = (char*)allocShared(sizeof(char) * (height + 1 + width + 1), &sequenceWindow, &node);
+	vectorWidth = vectorHeight + height + 1;
+
+	matrixHeight = width + height + 1;
+
+	readSequence(file, header[2], height, vectorHeight, sequenceWindow, &node);
+	readSequence(file, header[3], width, vectorWidth, sequenceWindow, &node);
+	MPI_File_close(&file);
+
+	if(height < width){
+		c = height;
+		height = width;
+		width = c;
+		vectorAux = vectorHeight;
+		vectorHeight = vectorWidth;
+		vectorWidth = vectorAux;
+		CHANGE = CHANGED;
 	}
-	MPI_Bcast(vectorHeight, height + 1, MPI_CHAR, 0, MPI_COMM_WORLD);
-	MPI_Bcast(vectorWidth, width + 1, MPI_CHAR, 0, MPI_COMM_WORLD);
-	MPI_Bcast(&matrixHeight, 1, MPI_INT, 0, MPI_COMM_WORLD);
-	MPI_Bcast(&CHANGE, 1, MPI_SHORT, 0, MPI_COMM_WORLD);
 
 
 	maxlenght_line = width + 1;
-	aux = EVEN(matrixHeight) ? matrixHeight / 2 : (matrixHeight / 2) + 1;
-	matrix = (short**)malloc(sizeof(short*) * matrixHeight);
-	c = 1;
-	for(n = 0; n < aux; n++){
-		matrix[n] = (short*)malloc(sizeof(short) * c);
-		if(n != (matrixHeight - 1 - n)) matrix[matrixHeight - 1 - n] = (short*)malloc(sizeof(short) * c);
-		c = (c < maxlenght_line) ? c + 1 : c;
+	ring = (short*)allocShared(sizeof(short) * 3 * maxlenght_line, &ringWindow, &node);
+	matrix = NULL;
+	if(rank == 0){
+		aux = EVEN(matrixHeight) ? matrixHeight / 2 : (matrixHeight / 2) + 1;
+		matrix = (short**)malloc(sizeof(short*) * matrixHeight);
+		c = 1;
+		for(n = 0; n < aux; n++){
+			matrix[n] = (short*)malloc(sizeof(short) * c);
+			if(n != (matrixHeight - 1 - n)) matrix[matrixHeight - 1 - n] = (short*)malloc(sizeof(short) * c);
+			c = (c < maxlenght_line) ? c + 1 : c;
+		}
 	}
 	Board result = (Board)malloc(sizeof(board_t));
 
@@ -161,75 +227,189 @@ Board parseFile(char* fileName, int rank, int numProc){
 	result->CHANGE = CHANGE;
 	result->rank = rank;
 	result->numProc = numProc;
+	result->node = node;
+	result->sequenceWindow = sequenceWindow;
+	result->ringWindow = ringWindow;
+	result->ring = ring;
 	return result;
 
 }
 
+/* Finds the first byte from offset that is not whitespace, read by rank 0 alone
+ * returns its offset, the end of the file if there is none
+ */
+MPI_Offset skipSpace(MPI_File file, MPI_Offset offset){
+	MPI_Status status;
+	char buffer[HEADER_BYTES];
+	int count, n;
+
+	for(;;){
+		MPI_File_read_at(file, offset, buffer, HEADER_BYTES, MPI_CHAR, &status);
+		MPI_Get_count(&status, MPI_CHAR, &count);
+		for(n = 0; n < count; n++){
+			if(buffer[n] != ' ' && buffer[n] != '\t' && buffer[n] != '\r' && buffer[n] != '\n') return offset + n;
+		}
+		if(count < HEADER_BYTES) return offset + count;
+		offset += count;
+	}
+}
+
+/* Reads one sequence of the input with MPI-IO into node shared memory
+ * Every node reads one block of the sequence, split again among its ranks,
+ * and only the node leaders exchange their blocks
+ * offset, the byte where the sequence starts; length, its size;
+ * vector, the shared destination, filled from index 1
+ */
+void readSequence(MPI_File file, MPI_Offset offset, int length, char* vector, MPI_Win window, node_t* node){
+	MPI_Status status;
+	int nodeLow = (int)BLOCK_LOW(node->node, node->numNodes, length);
+	int nodeLength = (int)BLOCK_SIZE(node->node, node->numNodes, length);
+	int low = nodeLow + (int)BLOCK_LOW(node->nodeRank, node->nodeSize, nodeLength);
+	int counts[node->numNodes];
+	int displs[node->numNodes];
+	int i;
+
+	MPI_File_read_at_all(file, offset + low, vector + 1 + low, (int)BLOCK_SIZE(node->nodeRank, node->nodeSize, nodeLength), MPI_CHAR, &status);
+	syncNode(window, node);
+	if(node->nodeRank == 0){
+		vector[0] = '/';
+		if(node->numNodes > 1){
+			for(i = 0; i < node->numNodes; i++){
+				displs[i] = (int)BLOCK_LOW(i, node->numNodes, length);
+				counts[i] = (int)BLOCK_SIZE(i, node->numNodes, length);
+			}
+			MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, vector + 1, counts, displs, MPI_CHAR, node->leaderComm);
+		}
+	}
+	syncNode(window, node);
+}
+
+/* Function that finds the ranks sharing memory with this one
+ * Each node gets a leader, its lowest rank, and the anti-diagonal blocks
+ * are numbered node by node so the blocks of a node are contiguous
+ * node, filled in; rank, the MPI rank
+ */
+void initNode(node_t* node, int rank){
+	int n;
+
+	MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node->nodeComm);
+	MPI_Comm_rank(node->nodeComm, &node->nodeRank);
+	MPI_Comm_size(node->nodeComm, &node->nodeSize);
+	MPI_Comm_split(MPI_COMM_WORLD, (node->nodeRank == 0) ? 0 : MPI_UNDEFINED, rank, &node->leaderComm);
+	if(node->nodeRank == 0){
+		MPI_Comm_rank(node->leaderComm, &node->node);
+		MPI_Comm_size(node->leaderComm, &node->numNodes);
+	}
+	MPI_Bcast(&node->node, 1, MPI_INT, 0, node->nodeComm);
+	MPI_Bcast(&node->numNodes, 1, MPI_INT, 0, node->nodeComm);
+
+	node->firstWork = (int*)malloc(sizeof(int) * (node->numNodes + 1));
+	if(node->nodeRank == 0){
+		MPI_Allgather(&node->nodeSize, 1, MPI_INT, node->firstWork + 1, 1, MPI_INT, node->leaderComm);
+		node->firstWork[0] = 0;
+		for(n = 1; n <= node->numNodes; n++) node->firstWork[n] += node->firstWork[n - 1];
+	}
+	MPI_Bcast(node->firstWork, node->numNodes + 1, MPI_INT, 0, node->nodeComm);
+	node->workRank = node->firstWork[node->node] + node->nodeRank;
+}
+
+/* Function that allocates memory shared by the ranks of a node
+ * The leader owns the memory, the others map it, and the window
+ * stays locked so syncNode is the only synchronization needed
+ * returns the base of the shared memory
+ */
+void* allocShared(MPI_Aint bytes, MPI_Win* window, node_t* node){
+	void* base;
+	MPI_Aint size;
+	int unit;
+
+	MPI_Win_allocate_shared((node->nodeRank == 0) ? bytes : 0, 1, MPI_INFO_NULL, node->nodeComm, &base, window);
+	MPI_Win_shared_query(*window, 0, &size, &unit, &base);
+	MPI_Win_lock_all(MPI_MODE_NOCHECK, *window);
+	return base;
+}
+
+/* Function that makes the writes of every rank of the node visible to all
+ */
+void syncNode(MPI_Win window, node_t* node){
+	MPI_Win_sync(window);
+	MPI_Barrier(node->nodeComm);
+	MPI_Win_sync(window);
+}
+
 void iterateBoard(board_t* board){
-	int i,j, matrixHeight = board->matrixHeight;
-	size_t line, index;
-	int rank = board->rank;
+	node_t* node = &board->node;
+	int matrixHeight = board->matrixHeight;
 	int numProc = board->numProc;
-	int length_line;
 	int height = board->height;
 	int width = board->width;
-	short* vectorToProcess;
-	short* vector2LinesAbove;
+	int ringLength = width + 1;
+	int length_line, low, n;
+	size_t line;
+	short* current;
 	short* vector1LineAbove;
-	int counts[numProc];
-	int displs[numProc];
+	short* vector2LinesAbove;
+	int counts[node->numNodes];
+	int displs[node->numNodes];
 
-	for (line = 0; line < matrixHeight; line++) {
+	restoreRing(board);
+	for (line = board->firstLine; line < matrixHeight; line++) {
 		length_line = getLength_Line(line,height, width);
+		current = board->ring + (line % 3) * ringLength;
+		vector1LineAbove = board->ring + ((line + 2) % 3) * ringLength;
+		vector2LinesAbove = board->ring + ((line + 1) % 3) * ringLength;
 		if(length_line >= numProc && line > 1){
-			for(i = 0; i < numProc; i++){
-				displs[i] = (int)BLOCK_LOW(i, numProc, length_line);
-				counts[i] = (int)BLOCK_SIZE(i, numProc,length_line);
-			}
-
-			vectorToProcess = (short*)malloc(sizeof(short) * BLOCK_SIZE(rank, numProc,length_line));
-			if(rank == 0){
-				vector2LinesAbove = board->matrix[line-2];
-				vector1LineAbove = board->matrix[line-1];
-			}
-			else{
-				vector2LinesAbove = (short*)malloc(sizeof(short) * getLength_Line(line -2, height, width));
-				vector1LineAbove = 	(short*)malloc(sizeof(short) * getLength_Line(line -1, height, width));
+			low = (int)BLOCK_LOW(node->workRank, numProc, length_line);
+			processSubLine(vector1LineAbove, vector2LinesAbove, current + low, BLOCK_SIZE(node->workRank, numProc, length_line), low, line, board);
+			syncNode(board->ringWindow, node);
+			if(node->numNodes > 1){
+				if(node->nodeRank == 0){
+					for(n = 0; n < node->numNodes; n++){
+						displs[n] = (int)BLOCK_LOW(node->firstWork[n], numProc, length_line);
+						counts[n] = (int)BLOCK_LOW(node->firstWork[n + 1], numProc, length_line) - displs[n];
+					}
+					MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, current, counts, displs, MPI_SHORT, node->leaderComm);
+				}
+				syncNode(board->ringWindow, node);
 			}
-
-			MPI_Bcast(vector1LineAbove, getLength_Line(line -1, height, width),MPI_SHORT,0,MPI_COMM_WORLD);
-			MPI_Bcast(vector2LinesAbove, getLength_Line(line -2, height, width),MPI_SHORT,0,MPI_COMM_WORLD);
-
-			processSubLine(vector1LineAbove, vector2LinesAbove, vectorToProcess, BLOCK_SIZE(rank, numProc,length_line), line, board);
-
-			MPI_Gatherv(vectorToProcess,BLOCK_SIZE(rank, numProc,length_line),MPI_SHORT,board->matrix[line],counts, displs,MPI_SHORT,0,MPI_COMM_WORLD);
-
-			if(rank != 0){
-				free(vector1LineAbove);
-				free(vector2LinesAbove);
+		}else{
+			if(node->nodeRank == 0)
+				processSubLine(vector1LineAbove, vector2LinesAbove, current, length_line, 0, line, board);
+			syncNode(board->ringWindow, node);
+		}
+		if(board->rank == 0){
+			memcpy(board->matrix[line], current, sizeof(short) * length_line);
+			if(board->checkpointDir != NULL && (line + 1) % board->checkpointEvery == 0){
+				checkpointLines(board, line + 1);
 			}
-			free(vectorToProcess);
-		}else if(rank == 0){
-			if(line < 2)
-				processSubLine(vector1LineAbove, vector2LinesAbove, board->matrix[line], getLength_Line(line,height, width), line, board);
-			else
-				processSubLine(board->matrix[line-1], board->matrix[line-2], board->matrix[line], getLength_Line(line,height, width), line, board);
-
 		}
 	}
 }
 
-void processSubLine(short* vector1LineAbove, short* vector2LineAbove, short* vectorToProcess, int vectorToProcessLength, int line, Board board){
-	int globalIndex, localIndex;
-	int rank = board->rank;
-	int numProc = board->numProc;
-	int height = board->height;
-	int width = board->width;
+/* Function that puts the last two restored anti-diagonals back in the
+ * shared ring of every node before a restart
+ */
+void restoreRing(Board board){
+	node_t* node = &board->node;
+	int ringLength = board->width + 1;
+	int line, length;
+	short* slot;
+
+	for(line = MAX(board->firstLine - 2, 0); line < board->firstLine; line++){
+		length = getLength_Line(line, board->height, board->width);
+		slot = board->ring + (line % 3) * ringLength;
+		if(board->rank == 0) memcpy(slot, board->matrix[line], sizeof(short) * length);
+		if(node->nodeRank == 0 && node->numNodes > 1) MPI_Bcast(slot, length, MPI_SHORT, 0, node->leaderComm);
+	}
+	syncNode(board->ringWindow, node);
+}
+
+void processSubLine(short* vector1LineAbove, short* vector2LineAbove, short* vectorToProcess, int vectorToProcessLength, int firstIndex, int line, Board board){
+	int localIndex;
 
 #pragma omp parallel for shared(vectorToProcess) private(localIndex)
 	for(localIndex = 0; localIndex < vectorToProcessLength; localIndex++){
-		globalIndex = localIndex + BLOCK_LOW(rank, numProc, getLength_Line(line,height, width));
-		vectorToProcess[localIndex] = processCell(vector1LineAbove, vector2LineAbove, line, globalIndex, board);
+		vectorToProcess[localIndex] = processCell(vector1LineAbove, vector2LineAbove, line, firstIndex + localIndex, board);
 	}
 }
 short processCell(short* vector1LineAbove, short* vector2LineAbove, int line, int globalIndex, Board board){
@@ -370,17 +550,275 @@ void printResults(board_t* board){
 void cleanAll(board_t* board){
 	size_t n;
 
-	free(board->vectorHeight);
-	free(board->vectorWidth);
+	MPI_Win_unlock_all(board->sequenceWindow);
+	MPI_Win_free(&board->sequenceWindow);
+	MPI_Win_unlock_all(board->ringWindow);
+	MPI_Win_free(&board->ringWindow);
 
-	for(n = 0; n < board->matrixHeight; n++){
-		free(board->matrix[n]);
+	if(board->matrix != NULL){
+		for(n = 0; n < board->matrixHeight; n++){
+			free(board->matrix[n]);
+		}
+		free(board->matrix);
 	}
-	free(board->matrix);
 
+	free(board->node.firstWork);
+	if(board->node.leaderComm != MPI_COMM_NULL) MPI_Comm_free(&board->node.leaderComm);
+	MPI_Comm_free(&board->node.nodeComm);
 	free(board);
 }
 
+/* Function that computes the peak memory of one rank
+ * The sequences and the ring of three anti-diagonals are shared by
+ * the node, so each rank is charged its share; only rank 0 keeps
+ * all the anti-diagonals and the subsequence for the traceback
+ * height, width the sizes, height >= width; nodeSize, the ranks on the node
+ * returns the peak in bytes
+ */
+size_t peakMemory(int height, int width, int rank, int nodeSize){
+	size_t lines = (size_t)height + width + 1;
+	size_t shared = (size_t)height + 1 + (size_t)width + 1 + sizeof(short) * 3 * ((size_t)width + 1);
+	size_t bytes = sizeof(board_t) + shared / nodeSize;
+
+	if(rank == 0){
+		bytes += sizeof(short*) * lines;
+		bytes += sizeof(short) * ((size_t)height + 1) * ((size_t)width + 1);
+		bytes += sizeof(char) * (size_t)width;
+	}
+	return bytes;
+}
+
+/* Function that reads the memory budget
+ * LCS_MEM_BUDGET accepts a byte count with an optional K, M or G suffix
+ * returns the budget, the physical memory when it is not set
+ */
+size_t memoryBudget(){
+	char* value = getenv("LCS_MEM_BUDGET");
+	char* suffix;
+	double budget;
+
+	if (value == NULL || *value == '\0') {
+		return (size_t)sysconf(_SC_PHYS_PAGES) * (size_t)sysconf(_SC_PAGE_SIZE);
+	}
+	budget = strtod(value, &suffix);
+	switch (*suffix) {
+		case 'G': case 'g': budget *= 1024.0 * 1024 * 1024; break;
+		case 'M': case 'm': budget *= 1024.0 * 1024; break;
+		case 'K': case 'k': budget *= 1024.0; break;
+	}
+	return (size_t)budget;
+}
+
+/* Function that checks every rank fits its budget before anything is allocated
+ * Rank 0 reports the plan on stderr, a rank that does not fit aborts the job
+ * height, width the sizes; rank, the MPI rank; node, the ranks sharing memory
+ */
+void planMemory(int height, int width, int rank, node_t* node){
+	size_t budget = memoryBudget();
+	size_t peak = peakMemory(MAX(height, width), MIN(height, width), rank, node->nodeSize);
+
+	if (peak > budget) {
+		fprintf(stderr, "plan: rank %d needs %zu bytes, budget %zu bytes\n", rank, peak, budget);
+		MPI_Abort(MPI_COMM_WORLD, 5);
+	}
+	if (rank == 0) {
+		fprintf(stderr, "plan: anti-diagonals on rank 0, shared wavefront on %d node(s), peak %zu bytes on rank 0, budget %zu bytes\n",
+		        node->numNodes, peak, budget);
+	}
+}
+
+/* Hashes both sequences so a checkpoint is only reused for the same input
+ * returns the FNV-1a hash
+ */
+unsigned long hashInput(Board board){
+	unsigned long hash = 14695981039346656037UL;
+	int n;
+
+	for(n = 0; n <= board->height; n++){
+		hash = (hash ^ (unsigned char)board->vectorHeight[n]) * 1099511628211UL;
+	}
+	for(n = 0; n <= board->width; n++){
+		hash = (hash ^ (unsigned char)board->vectorWidth[n]) * 1099511628211UL;
+	}
+	return hash;
+}
+
+void checkpointPath(Board board, char* path, char* suffix){
+	snprintf(path, 4096, "%s/lcs-%d.ckpt%s", board->checkpointDir, board->rank, suffix);
+}
+
+/* Function that sets up checkpoints from LCS_CHECKPOINT_DIR and LCS_CHECKPOINT_EVERY
+ * Rank 0 holds every computed anti-diagonal, the other ranks only get the
+ * two above the current one each line, so only rank 0 has state to save
+ * Resumes from the checkpoint of the same input when there is one
+ */
+void initCheckpoint(Board board){
+	char path[4096];
+	char* every = getenv("LCS_CHECKPOINT_EVERY");
+	checkpoint_header_t header;
+	FILE* file;
+	int firstLine = 0;
+
+	board->checkpointDir = getenv("LCS_CHECKPOINT_DIR");
+	if(board->checkpointDir != NULL && *board->checkpointDir == '\0') board->checkpointDir = NULL;
+	board->checkpointEvery = (every != NULL && atoi(every) > 0) ? atoi(every) : CHECKPOINT_EVERY;
+	board->writing = 0;
+
+	if(board->rank == 0 && board->checkpointDir != NULL){
+		firstLine = restoreCheckpoint(board);
+		if(firstLine == 0){
+			memset(&header, 0, sizeof(header));
+			memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+			header.height = board->height;
+			header.width = board->width;
+			header.CHANGE = board->CHANGE;
+			header.hash = hashInput(board);
+			checkpointPath(board, path, ".line");
+			unlink(path);
+			checkpointPath(board, path, "");
+			if(!(file = fopen(path, "wb")) || fwrite(&header, sizeof(header), 1, file) != 1){
+				fprintf(stderr, "Error creating checkpoint \"%s\", checkpoints are off\n", path);
+				board->checkpointDir = NULL;
+			}
+			if(file) fclose(file);
+		}
+	}
+	MPI_Bcast(&firstLine, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	board->firstLine = firstLine;
+	board->checkpointedLines = firstLine;
+}
+
+/* Function that loads the anti-diagonals of the latest consistent checkpoint
+ * The line file is only renamed into place after the data is synced
+ * returns the number of lines loaded, 0 when there is nothing to resume
+ */
+int restoreCheckpoint(Board board){
+	char path[4096];
+	checkpoint_header_t header;
+	FILE* file;
+	int lines, line, length;
+
+	checkpointPath(board, path, ".line");
+	if(!(file = fopen(path, "r"))) return 0;
+	if(fscanf(file, "%d", &lines) != 1) lines = 0;
+	fclose(file);
+	if(lines <= 0 || lines > board->matrixHeight) return 0;
+
+	checkpointPath(board, path, "");
+	if(!(file = fopen(path, "rb"))) return 0;
+	if(fread(&header, sizeof(header), 1, file) != 1 ||
+	   memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) ||
+	   header.height != board->height || header.width != board->width ||
+	   header.CHANGE != board->CHANGE || header.hash != hashInput(board)){
+		fprintf(stderr, "Checkpoint \"%s\" is for another input, starting over\n", path);
+		fclose(file);
+		return 0;
+	}
+	for(line = 0; line < lines; line++){
+		length = getLength_Line(line, board->height, board->width);
+		if(fread(board->matrix[line], sizeof(short), length, file) != (size_t)length){
+			fprintf(stderr, "Checkpoint \"%s\" is truncated, starting over\n", path);
+			fclose(file);
+			return 0;
+		}
+	}
+	fclose(file);
+	fprintf(stderr, "restart: resuming at anti-diagonal %d of %d\n", lines, board->matrixHeight);
+	return lines;
+}
+
+/* Function that hands the anti-diagonals computed since the last checkpoint to the writer
+ * Waits for the previous write first, the fill goes on while this one runs
+ * A failed write leaves checkpointedLines where it was, so the next one
+ * rewrites the same lines from the same offset
+ * lines, the number of anti-diagonals done
+ */
+void checkpointLines(Board board, int lines){
+	void* saved;
+
+	if(board->writing){
+		pthread_join(board->writer, &saved);
+		if(saved == CHECKPOINT_SAVED) board->checkpointedLines = board->writeTo;
+		board->writing = 0;
+	}
+	board->writeTo = lines;
+	if(pthread_create(&board->writer, NULL, writeCheckpoint, board) == 0){
+		board->writing = 1;
+	}
+}
+
+/* Writer thread, appends anti-diagonals checkpointedLines..writeTo-1
+ * Those lines are final, so they are read without a copy
+ * Syncs the data before moving the new line count into place
+ * returns CHECKPOINT_SAVED, or NULL when anything failed
+ */
+void* writeCheckpoint(void* arg){
+	Board board = (Board)arg;
+	char path[4096];
+	char tmpPath[4096];
+	FILE* file;
+	off_t offset = sizeof(checkpoint_header_t);
+	int line, length;
+
+	for(line = 0; line < board->checkpointedLines; line++){
+		offset += sizeof(short) * getLength_Line(line, board->height, board->width);
+	}
+	checkpointPath(board, path, "");
+	if(!(file = fopen(path, "r+b")) || fseeko(file, offset, SEEK_SET)){
+		fprintf(stderr, "Error writing checkpoint \"%s\"\n", path);
+		if(file) fclose(file);
+		return NULL;
+	}
+	for(line = board->checkpointedLines; line < board->writeTo; line++){
+		length = getLength_Line(line, board->height, board->width);
+		if(fwrite(board->matrix[line], sizeof(short), length, file) != (size_t)length){
+			fprintf(stderr, "Error writing checkpoint \"%s\"\n", path);
+			fclose(file);
+			return NULL;
+		}
+	}
+	if(fflush(file) || fsync(fileno(file))){
+		fprintf(stderr, "Error writing checkpoint \"%s\"\n", path);
+		fclose(file);
+		return NULL;
+	}
+	fclose(file);
+
+	checkpointPath(board, tmpPath, ".line.tmp");
+	checkpointPath(board, path, ".line");
+	if(!(file = fopen(tmpPath, "w"))){
+		fprintf(stderr, "Error writing checkpoint \"%s\"\n", tmpPath);
+		return NULL;
+	}
+	if(fprintf(file, "%d\n", board->writeTo) < 0 || fflush(file) || fsync(fileno(file))){
+		fprintf(stderr, "Error writing checkpoint \"%s\"\n", tmpPath);
+		fclose(file);
+		return NULL;
+	}
+	fclose(file);
+	if(rename(tmpPath, path)){
+		fprintf(stderr, "Error writing checkpoint \"%s\"\n", path);
+		return NULL;
+	}
+	return CHECKPOINT_SAVED;
+}
+
+/* Waits for the writer and removes the checkpoint once the result is out
+ */
+void finishCheckpoint(Board board){
+	char path[4096];
+
+	if(board->checkpointDir == NULL) return;
+	if(board->writing){
+		pthread_join(board->writer, NULL);
+		board->writing = 0;
+	}
+	checkpointPath(board, path, ".line");
+	unlink(path);
+	checkpointPath(board, path, "");
+	unlink(path);
+}
+
 int getI(int line, int index, int height){
 	if(line <= height){
 		 return line - index;
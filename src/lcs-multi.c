@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+#define MAX(x, y) ( ((x) > (y)) ? (x) : (y) )
+#define MIN(x, y) ( ((x) > (y)) ? (y) : (x) )
+
+#define NUM_SEQUENCES 3
+#define TILE 64
+#define CUTOFF (256 * 256)	//planes smaller than this are filled by one thread
+
+typedef struct {
+	int length[NUM_SEQUENCES];	//height, width, depth; depth is the longest
+	char* vector[NUM_SEQUENCES];	//1-based, vector[n][0] = '/'
+	short* costTable;		//cost(i + j + k)
+	short* planes[4];		//two planes for each direction of the split
+	char* subsequence;
+	int size;			//characters found so far
+	int value;			//sum of their costs
+}board_t;
+
+typedef board_t* Board;
+
+typedef struct {
+	char* chars;	//the characters of the range, in the order they are visited
+	int* index;	//the global index of each of them
+	int length;
+}range_t;
+
+short cost(int x);
+Board parseFile(char* fileName);
+void makeRange(range_t* range, int first, int last, int reverse, char* vector);
+void processTile(int tx, int ty, range_t* a, range_t* b, char c, int k, short* plane, short* previous, Board board);
+short* fillPlanes(range_t* a, range_t* b, range_t* c, short* plane, short* previous, Board board);
+void matchOne(int i0, int i1, int j0, int j1, int k, Board board);
+void split(int i0, int i1, int j0, int j1, int k0, int k1, Board board);
+void printResults(board_t* board);
+void cleanAll(board_t* board);
+
+int main(int argc, char* argv[]){
+
+	char* fileName = argv[1];
+	Board board = parseFile(fileName);
+	split(1, board->length[0], 1, board->length[1], 1, board->length[2], board);
+	printResults(board);
+	cleanAll(board);
+	return 0;
+}
+
+/* Function that builds the characters and indexes of a range of a sequence
+ * reverse walks the range backwards, for the suffix planes
+ * range, filled in; first, last the bounds, 1-based; vector, the sequence
+ */
+void makeRange(range_t* range, int first, int last, int reverse, char* vector){
+	int n;
+
+	range->length = MAX(last - first + 1, 0);
+	range->chars = (char*)malloc(sizeof(char) * (range->length + 1));
+	range->index = (int*)malloc(sizeof(int) * (range->length + 1));
+	range->chars[0] = '/';
+	range->index[0] = 0;
+	for(n = 1; n <= range->length; n++){
+		range->index[n] = reverse ? last - n + 1 : first + n - 1;
+		range->chars[n] = vector[range->index[n]];
+	}
+}
+
+/* Function that fills one tile of a plane
+ * A match of the three characters adds its cost to the cell behind and
+ * up-left, otherwise the cell takes the max of up, left and behind
+ * tx, ty the tile; c, k the character and global index of the plane;
+ * plane, the plane being filled; previous, the plane behind it
+ */
+void processTile(int tx, int ty, range_t* a, range_t* b, char c, int k, short* plane, short* previous, Board board){
+	int columns = b->length + 1;
+	int x0 = tx * TILE + 1, x1 = MIN(x0 + TILE - 1, a->length);
+	int y0 = ty * TILE + 1, y1 = MIN(y0 + TILE - 1, b->length);
+	int x, y, cell;
+	short best;
+
+	for(x = x0; x <= x1; x++){
+		for(y = y0; y <= y1; y++){
+			cell = x * columns + y;
+			if(a->chars[x] == c && b->chars[y] == c){
+				plane[cell] = previous[cell - columns - 1] + board->costTable[a->index[x] + b->index[y] + k];
+			}else{
+				best = MAX(plane[cell - columns], plane[cell - 1]);
+				plane[cell] = MAX(best, previous[cell]);
+			}
+		}
+	}
+}
+
+/* Function that sweeps the ranges of the three sequences plane by plane
+ * Only two planes of (a + 1) * (b + 1) cells are kept, and each plane
+ * is filled tile anti-diagonal by tile anti-diagonal in parallel
+ * returns the last plane, LCS of every prefix of a and b with all of c
+ */
+short* fillPlanes(range_t* a, range_t* b, range_t* c, short* plane, short* previous, Board board){
+	int columns = b->length + 1;
+	int tilesX = (a->length + TILE - 1) / TILE;
+	int tilesY = (b->length + TILE - 1) / TILE;
+	int parallel = (long)a->length * b->length >= CUTOFF;
+	short* aux;
+	int k, d, tx;
+
+	memset(previous, 0, sizeof(short) * (a->length + 1) * columns);
+	memset(plane, 0, sizeof(short) * (a->length + 1) * columns);
+#pragma omp parallel if(parallel) private(k, d, tx)
+	for(k = 1; k <= c->length; k++){
+		for(d = 0; d < tilesX + tilesY - 1; d++){
+#pragma omp for schedule(dynamic)
+			for(tx = MAX(0, d - tilesY + 1); tx <= MIN(d, tilesX - 1); tx++){
+				processTile(tx, d - tx, a, b, c->chars[k], c->index[k], plane, previous, board);
+			}
+		}
+#pragma omp single
+		{
+			aux = previous;
+			previous = plane;
+			plane = aux;
+		}
+	}
+	return previous;
+}
+
+/* Function that solves a range with a single character of the depth
+ * The character is kept where it matches in both other ranges
+ * with the largest cost, at most one character can be added
+ */
+void matchOne(int i0, int i1, int j0, int j1, int k, Board board){
+	char c = board->vector[2][k];
+	short best = 0, value;
+	int i, j;
+
+	for(i = i0; i <= i1; i++){
+		if(board->vector[0][i] != c) continue;
+		for(j = j0; j <= j1; j++){
+			if(board->vector[1][j] != c) continue;
+			value = board->costTable[i + j + k];
+			if(value > best) best = value;
+		}
+	}
+	if(best > 0){
+		board->subsequence[board->size++] = c;
+		board->value += best;
+	}
+}
+
+/* Function that finds the subsequence of the box [i0,i1] x [j0,j1] x [k0,k1]
+ * Splits the depth in half, fills the prefix planes of the first half
+ * and the suffix planes of the second, and recurses on the two boxes
+ * around the best crossing point, so memory stays two planes per half
+ */
+void split(int i0, int i1, int j0, int j1, int k0, int k1, Board board){
+	range_t a, b, c, ra, rb, rc;
+	short *forward, *backward;
+	int mid = (k0 + k1) / 2;
+	int p, q, bestP = 0, bestQ = 0, best = -1, columns;
+
+	if(i0 > i1 || j0 > j1 || k0 > k1) return;
+	if(k0 == k1){
+		matchOne(i0, i1, j0, j1, k0, board);
+		return;
+	}
+
+	makeRange(&a, i0, i1, 0, board->vector[0]);
+	makeRange(&b, j0, j1, 0, board->vector[1]);
+	makeRange(&c, k0, mid, 0, board->vector[2]);
+	makeRange(&ra, i0, i1, 1, board->vector[0]);
+	makeRange(&rb, j0, j1, 1, board->vector[1]);
+	makeRange(&rc, mid + 1, k1, 1, board->vector[2]);
+
+	forward = fillPlanes(&a, &b, &c, board->planes[0], board->planes[1], board);
+	backward = fillPlanes(&ra, &rb, &rc, board->planes[2], board->planes[3], board);
+
+	columns = b.length + 1;
+	for(p = 0; p <= a.length; p++){
+		for(q = 0; q <= b.length; q++){
+			if(forward[p * columns + q] + backward[(a.length - p) * columns + (b.length - q)] > best){
+				best = forward[p * columns + q] + backward[(a.length - p) * columns + (b.length - q)];
+				bestP = p;
+				bestQ = q;
+			}
+		}
+	}
+	free(a.chars); free(a.index); free(b.chars); free(b.index); free(c.chars); free(c.index);
+	free(ra.chars); free(ra.index); free(rb.chars); free(rb.index); free(rc.chars); free(rc.index);
+
+	split(i0, i0 + bestP - 1, j0, j0 + bestQ - 1, k0, mid, board);
+	split(i0 + bestP, i1, j0 + bestQ, j1, mid + 1, k1, board);
+}
+
+/* Function that reads the file and builds the board
+ * The header has the length of each sequence, "height width depth",
+ * followed by one sequence per line
+ * The longest sequence becomes the depth, the one kept in linear space
+ * filename, the name of the file to be read
+ * returns the board
+ */
+Board parseFile(char* fileName){
+	FILE* file;
+	int length[NUM_SEQUENCES];
+	char* vector[NUM_SEQUENCES];
+	char* vectorAux;
+	size_t planeSize;
+	int c, n, s, longest = 0;
+
+	if (!(file = fopen(fileName,"r"))){
+		printf("Error opening file \"%s\"\n", fileName);
+		exit(2);
+	}
+	if(fscanf(file, "%d %d %d", &length[0], &length[1], &length[2]) != NUM_SEQUENCES){
+		printf("Could not read height, width and depth");
+		exit(3);
+	}
+	while((c = fgetc(file)) != '\n' && c != EOF);
+
+	for(s = 0; s < NUM_SEQUENCES; s++){
+		if(!(vector[s] = (char*) malloc(sizeof(char)*(length[s] + 1)))){
+			printf("Error allocating row pointers for board.\n");
+			exit(4);
+		}
+		n = 1;
+		while((c = fgetc(file)) != '\n' && c != EOF && n <= length[s]){
+			vector[s][n++] = (char)c;
+		}
+		vector[s][0] = '/';
+		if(length[s] > length[longest]) longest = s;
+	}
+	fclose(file);
+	file = NULL;
+
+	c = length[2]; length[2] = length[longest]; length[longest] = c;
+	vectorAux = vector[2]; vector[2] = vector[longest]; vector[longest] = vectorAux;
+
+	Board result = (Board)malloc(sizeof(board_t));
+
+	planeSize = ((size_t)length[0] + 1) * ((size_t)length[1] + 1);
+	for(s = 0; s < NUM_SEQUENCES; s++){
+		result->length[s] = length[s];
+		result->vector[s] = vector[s];
+	}
+	for(n = 0; n < 4; n++){
+		if(!(result->planes[n] = (short*)malloc(sizeof(short) * planeSize))){
+			printf("Error allocating row pointers for board.\n");
+			exit(4);
+		}
+	}
+	result->costTable = (short*)malloc(sizeof(short) * (length[0] + length[1] + length[2] + 1));
+	for(n = 0; n <= length[0] + length[1] + length[2]; n++){
+		result->costTable[n] = cost(n);
+	}
+	result->subsequence = (char*)malloc(sizeof(char) * (MIN(length[0], length[1]) + 1));
+	result->size = 0;
+	result->value = 0;
+
+	return result;
+}
+
+/* Prints the result of the LCS and the subsequence
+ */
+void printResults(board_t* board){
+	int n;
+
+	printf("%d\n", board->value);
+	for (n = 0; n < board->size; ++n) {
+		printf("%c", board->subsequence[n]);
+	}
+	printf("\n");
+}
+
+/* Function to add computation time
+ * returns 1 always
+ */
+short cost(int x){
+	int i, n_iter = 20;
+	double dcost = 0;
+	for(i = 0; i < n_iter; i++)
+		dcost += pow(sin((double) x),2) + pow(cos((double) x),2);
+	return (short) (dcost / n_iter + 0.1);
+}
+
+/*
+ * Clears the resourses used
+ */
+void cleanAll(board_t* board){
+	int n;
+
+	for(n = 0; n < NUM_SEQUENCES; n++){
+		free(board->vector[n]);
+	}
+	for(n = 0; n < 4; n++){
+		free(board->planes[n]);
+	}
+	free(board->costTable);
+	free(board->subsequence);
+	free(board);
+}
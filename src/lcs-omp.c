@@ -1,10 +1,55 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <omp.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <linux/mempolicy.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 
 #define MAX(x, y) ( ((x) > (y)) ? (x) : (y) )
+#define MIN(x, y) ( ((x) > (y)) ? (y) : (x) )
+
+#define ROWS 0
+#define RECURSIVE 1
+
+#define CUTOFF 64
+
+#define FULL_MATRIX 0
+
+#define MAX_NODES 64
+#define BLOCK_COLUMNS 1024	//columns of a node band filled before the next node may start
+
+#define PARSE 0
+#define FILL 1
+#define TRACEBACK 2
+#define PHASES 3
+
+#define NUM_EVENTS 4	//cycles, instructions, cache misses, branch misses
+
+#define TABLE 0
+#define JSON 1
+
+typedef struct {
+	int numNodes;			//nodes that got threads, 1 without NUMA
+	int nodeId[MAX_NODES];		//kernel number of each node
+	cpu_set_t cpus[MAX_NODES];
+	int* threadNode;		//node of each thread
+	int pinned;			//1 when the threads were pinned to their node
+	int hugePages;			//1 with LCS_HUGEPAGES
+	short int* slab[MAX_NODES];	//rows owned by each node
+	size_t slabBytes[MAX_NODES];
+	int rows[MAX_NODES];		//rows in each slab
+	int firstRow[MAX_NODES + 1];	//recursive fill, the band of rows of each node
+	double seconds[MAX_NODES];	//time each node spent filling
+}numa_t;
 
 typedef struct {
 	int height;
@@ -12,11 +57,30 @@ typedef struct {
 	char* vectorHeight;
 	char* vectorWidth;
 	short int** matrix;
-	omp_lock_t* locks;
+	omp_lock_t* locks;	//NULL with the recursive fill
+	short fill;		//ROWS or RECURSIVE
+	int step;		//rows between checkpoints, FULL_MATRIX keeps every row
+	short int** checkpoints;
+	int numSlots;		//blocks recomputed at once during the backtrack
+	short int*** slots;	//step rows per slot
+	short int*** slotMatrix;	//row pointers of each slot, by matrix line
+	numa_t numa;
 }board_t;
 
 typedef board_t* Board;
 
+typedef struct {
+	short format;		//TABLE or JSON
+	short available;	//1 once any counter was read
+	int error;		//errno of the last counter that failed to open
+	int threads;
+	int* fd;		//NUM_EVENTS per thread
+	long long* values;	//by phase, thread and event, -1 when missing
+	double seconds[PHASES];
+}counters_t;
+
+typedef counters_t* Counters;
+
 short cost(int x);
 Board parseFile(char* fileName);
 void processCell(int i, int j, Board board);
@@ -26,14 +90,51 @@ void cleanAll(board_t* board);
 void lockCell(int i, int j, Board board);
 void unlockCell(int i, int j, Board board);
 void lockLine(int i, Board board);
+size_t memoryBudget();
+size_t peakMemory(int height, int width, short fill, int step);
+int planMemory(int height, int width, short fill);
+short chooseFill();
+int wantReport(char* name);
+void processCellRecursive(int i, int j, short int** matrix, Board board);
+void fillRecursive(int i0, int i1, int j0, int j1, short int** matrix, Board board);
+void recomputeBlock(int block, int columns, int slot, Board board);
+void backtrackBlocks(board_t* board, char* subsequence, int finalSize);
+Counters initCounters();
+int openCounter(unsigned long long config);
+void startPhase(Counters counters, int phase);
+void stopPhase(Counters counters, int phase);
+void printCount(long long value, short format);
+void printCounters(Counters counters);
+int parseCpuList(char* list, cpu_set_t* cpus);
+void initNuma(numa_t* numa);
+int rowOwner(int i, Board board);
+void allocMatrix(Board board);
+void fillNodes(Board board);
+double localPages(short int* slab, size_t bytes, int nodeId);
+void printNuma(Board board, double seconds);
 
 
 int main(int argc, char* argv[]){
 
 	char* fileName = argv[1];
+	Counters counters = initCounters();
+	startPhase(counters, PARSE);
 	Board board = parseFile(fileName);
+	stopPhase(counters, PARSE);
+	double start = omp_get_wtime();
+	startPhase(counters, FILL);
 	iterateBoard(board);
+	stopPhase(counters, FILL);
+	if(wantReport("fill")){
+		fprintf(stderr, "fill: %s, %d threads, %.3f s\n", (board->fill == RECURSIVE) ? "recursive" : "rows",
+		        omp_get_max_threads(), omp_get_wtime() - start);
+	}
+	if(wantReport("numa")) printNuma(board, omp_get_wtime() - start);
+	startPhase(counters, TRACEBACK);
 	printResults(board);
+	fflush(stdout);
+	stopPhase(counters, TRACEBACK);
+	printCounters(counters);
 	cleanAll(board);
 	return 0;
 }
@@ -61,14 +162,46 @@ void processCell(int i, int j, Board board){
 }
 
 /* Function that iterates through the matrix
- * Each thread locks the lines it's going to process
- * Calls the processCell funtion on each cell
+ * The recursive fill goes quadrant by quadrant, on a checkpointed board
+ * one band of step rows at a time
+ * With the row fill each thread locks the lines it's going to process
+ * and calls the processCell funtion on each cell
  * board, the current board
  */
 void iterateBoard(board_t* board){
 	int heightLength = board->height + 1;
 	int widthLength = board->width + 1;
+	int step = board->step;
+	int first, last;
 	size_t i, j;
+
+	if(board->fill == RECURSIVE && board->step == FULL_MATRIX){
+		if(board->numa.numNodes > 1){
+			fillNodes(board);
+			return;
+		}
+#pragma omp parallel
+#pragma omp single
+		fillRecursive(0, board->height, 0, board->width, board->matrix, board);
+		return;
+	}
+	if(board->step != FULL_MATRIX){
+		/* band by band, only the last row of each band is kept */
+		board->matrix[0] = board->checkpoints[0];
+		for(j = 0; j < widthLength; ++j){
+			processCellRecursive(0, j, board->matrix, board);
+		}
+		for(first = 0; first < board->height; first += step){
+			last = MIN(first + step, board->height);
+			for(i = first + 1; i <= last; i++){
+				board->matrix[i] = (i % step == 0) ? board->checkpoints[i / step] : board->slots[0][i - first - 1];
+			}
+#pragma omp parallel
+#pragma omp single
+			fillRecursive(first + 1, last, 0, board->width, board->matrix, board);
+		}
+		return;
+	}
 #pragma omp parallel private(i,j) shared(board)
 	{
 #pragma omp for schedule(static, 1)
@@ -87,6 +220,149 @@ void iterateBoard(board_t* board){
 	}
 }
 
+/* Same recurrence as processCell without the locks
+ * The recursive fill orders the quadrants so no cell is read before it is written
+ * i, the line; j, the column; matrix, the row pointers to fill; board, the current board
+ */
+void processCellRecursive(int i, int j, short int** matrix, Board board){
+	if (i == 0 || j == 0) {
+		matrix[i][j] = 0;
+	} else if (board->vectorHeight[i] == board->vectorWidth[j]) {
+		matrix[i][j] = matrix[i - 1][j - 1] + cost(i+j);
+	}else{
+		matrix[i][j] = MAX(matrix[i - 1][j], matrix[i][j - 1]);
+	}
+}
+
+/* Cache-oblivious fill of rows i0..i1 and columns j0..j1
+ * Splits into quadrants: the top left one first, then the top right and
+ * bottom left ones as parallel tasks, then the bottom right one
+ * Every level of the recursion fits some level of the cache, so there is
+ * no tile size to tune, CUTOFF only bounds the task overhead
+ */
+void fillRecursive(int i0, int i1, int j0, int j1, short int** matrix, Board board){
+	int im = (i0 + i1) / 2;
+	int jm = (j0 + j1) / 2;
+	int i, j;
+
+	if (i1 - i0 < CUTOFF && j1 - j0 < CUTOFF) {
+		for (i = i0; i <= i1; ++i) {
+			for (j = j0; j <= j1; ++j) {
+				processCellRecursive(i, j, matrix, board);
+			}
+		}
+	} else if (i1 - i0 < CUTOFF) {
+		fillRecursive(i0, i1, j0, jm, matrix, board);
+		fillRecursive(i0, i1, jm + 1, j1, matrix, board);
+	} else if (j1 - j0 < CUTOFF) {
+		fillRecursive(i0, im, j0, j1, matrix, board);
+		fillRecursive(im + 1, i1, j0, j1, matrix, board);
+	} else {
+		fillRecursive(i0, im, j0, jm, matrix, board);
+#pragma omp task
+		fillRecursive(i0, im, jm + 1, j1, matrix, board);
+		fillRecursive(im + 1, i1, j0, jm, matrix, board);
+#pragma omp taskwait
+		fillRecursive(im + 1, i1, jm + 1, j1, matrix, board);
+	}
+}
+
+/* Function that recomputes one block of a checkpointed board into a slot
+ * Only columns 0..columns, the backtrack never goes right of where it is
+ * block, the block below checkpoint block; slot, the buffers to use
+ */
+void recomputeBlock(int block, int columns, int slot, Board board){
+	int first = block * board->step;
+	int last = MIN(first + board->step, board->height);
+	short int** matrix = board->slotMatrix[slot];
+	int i, j, r;
+
+	matrix[first] = board->checkpoints[block];
+	for (r = 1; r <= last - first; ++r) {
+		matrix[first + r] = board->slots[slot][r - 1];
+	}
+	for (i = first + 1; i <= last; ++i) {
+		for (j = 0; j <= columns; ++j) {
+			processCellRecursive(i, j, matrix, board);
+		}
+	}
+}
+
+/* Backtrack of a checkpointed board
+ * Each round recomputes the next numSlots blocks up the path in parallel,
+ * blocks only depend on their checkpoint, then walks them one after the
+ * other with the printResults rules, each writes its own fragment of the
+ * subsequence
+ * board, the current board; subsequence, where to write; finalSize, its length
+ */
+void backtrackBlocks(board_t* board, char* subsequence, int finalSize){
+	int heightLength = board->height;
+	int widthLength = board->width;
+	int aux = finalSize;
+	int top, count, slot, first, columns;
+	short int** matrix;
+
+	while(aux > 0){
+		top = (heightLength - 1) / board->step;
+		count = MIN(board->numSlots, top + 1);
+		columns = widthLength;
+#pragma omp parallel for schedule(dynamic, 1)
+		for(slot = 0; slot < count; slot++){
+			recomputeBlock(top - slot, columns, slot, board);
+		}
+
+		for(slot = 0; slot < count && aux > 0; slot++){
+			matrix = board->slotMatrix[slot];
+			first = (top - slot) * board->step;
+			while(aux > 0 && heightLength > first){
+				if((matrix[heightLength-1][widthLength] != aux) &&
+				   (matrix[heightLength][widthLength-1] != aux)){
+					subsequence[aux -1] = board->vectorHeight[heightLength];
+					heightLength--;
+					widthLength--;
+					aux--;
+				}else if (board->vectorHeight[heightLength] == board->vectorWidth[widthLength]) {
+					subsequence[aux -1] = board->vectorHeight[heightLength];
+					heightLength--;
+					widthLength--;
+					aux--;
+				}else if (matrix[heightLength][widthLength-1] == aux) {
+					widthLength--;
+				}else if (matrix[heightLength-1][widthLength] == aux) {
+					heightLength--;
+				}
+			}
+		}
+	}
+}
+
+/* Function that picks the fill from LCS_FILL
+ * rows (the default), the locked row by row fill, or recursive
+ */
+short chooseFill(){
+	char* fill = getenv("LCS_FILL");
+
+	if (fill == NULL || *fill == '\0' || !strcmp(fill, "rows")) return ROWS;
+	if (!strcmp(fill, "recursive")) return RECURSIVE;
+	fprintf(stderr, "Unknown LCS_FILL \"%s\", use rows or recursive\n", fill);
+	exit(1);
+}
+
+/* Function that tells if a report was asked for in LCS_REPORT,
+ * a comma separated list, e.g. LCS_REPORT=fill
+ * returns 1 if name is in the list
+ */
+int wantReport(char* name){
+	char* reports = getenv("LCS_REPORT");
+	size_t length = strlen(name);
+	char* found;
+
+	if (reports == NULL) return 0;
+	for (found = strstr(reports, name); found != NULL; found = strstr(found + 1, name)) {
+		if ((found == reports || found[-1] == ',') && (found[length] == '\0' || found[length] == ',')) return 1;
+	}
+	return 0;
+}
 
 /* Function that reads the file and builds the board
  * Builds the vertical and horizontal string, and allocs for matrix postions
@@ -102,7 +378,12 @@ Board parseFile(char* fileName){
 	char* vectorWeidth;
 	short int** matrix;
 	size_t n = 1;
-	omp_lock_t* locks;
+	omp_lock_t* locks = NULL;
+	short fill = chooseFill();
+	short int** checkpoints = NULL;
+	short int*** slots = NULL;
+	short int*** slotMatrix = NULL;
+	int step, numSlots = omp_get_max_threads(), r;
 
 
 	if (!(file = fopen(fileName,"r"))){
@@ -113,6 +394,7 @@ Board parseFile(char* fileName){
 	    printf("Could not read height and width");
 	    exit(3);
 	}
+	step = planMemory(height, width, fill);
 	if(!(vectorHeight = (char*) malloc(sizeof(char)*(height + 1)))||
 	   !(vectorWeidth = (char*) malloc(sizeof(char)*(width + 1)))){
 		    printf("Error allocating row pointers for board.\n");
@@ -130,7 +412,9 @@ Board parseFile(char* fileName){
 	}
 	
 	Board result = (Board)malloc(sizeof(board_t));
-	locks = (omp_lock_t*)malloc(sizeof(omp_lock_t)*(height+1)*(width+1));
+	if(fill == ROWS){
+		locks = (omp_lock_t*)malloc(sizeof(omp_lock_t)*(height+1)*(width+1));
+	}
 
 
 
@@ -150,16 +434,34 @@ Board parseFile(char* fileName){
 	#pragma omp section
 	matrix = (short int**)malloc(sizeof(short int*) * (height + 1));
 	}
+	if(step != FULL_MATRIX){
+	#pragma omp single
+	{
+	checkpoints = (short int**)malloc(sizeof(short int*) * (height / step + 1));
+	slots = (short int***)malloc(sizeof(short int**) * numSlots);
+	slotMatrix = (short int***)malloc(sizeof(short int**) * numSlots);
+	}
 	#pragma omp for private (n)
-	for (n = 0; n < height + 1; ++n) {
-		matrix[n] = (short int*)malloc(sizeof(short int) * (width + 1));
+	for (n = 0; n < height / step + 1; ++n) {
+		checkpoints[n] = (short int*)malloc(sizeof(short int) * (width + 1));
+	}
+	#pragma omp for private (n, r)
+	for (n = 0; n < numSlots; ++n) {
+		slots[n] = (short int**)malloc(sizeof(short int*) * step);
+		for (r = 0; r < step; ++r) {
+			slots[n][r] = (short int*)malloc(sizeof(short int) * (width + 1));
+		}
+		slotMatrix[n] = (short int**)malloc(sizeof(short int*) * (height + 1));
+	}
 	}
 	
 		
+	if(fill == ROWS){
 	#pragma omp for private (n)
 	for(n = 0; n < ((height+1) * (width +1)); n++){
 		omp_init_lock(&(locks[n]));
 	}
+	}
 
 	#pragma omp sections
 	{
@@ -175,8 +477,20 @@ Board parseFile(char* fileName){
 	result->vectorWidth = vectorWeidth;
 	#pragma omp section
 	result->locks = locks;
+	#pragma omp section
+	result->fill = fill;
+	#pragma omp section
+	{
+	result->step = step;
+	result->checkpoints = checkpoints;
+	result->numSlots = numSlots;
+	result->slots = slots;
+	result->slotMatrix = slotMatrix;
+	}
 	}
 }
+	result->numa.numNodes = 1;
+	if(step == FULL_MATRIX) allocMatrix(result);
 	return result;
 
 }
@@ -212,6 +526,10 @@ void printResults(board_t* board){
 	/* just for testing */
 
 	aux = finalSize;
+	if(board->step != FULL_MATRIX){
+		backtrackBlocks(board, subsequence, finalSize);
+		aux = 0;
+	}
 	while(aux > 0){
 		if((matrix[heightLength-1][widthLength] != aux) &&
 		   (matrix[heightLength][widthLength-1] != aux)){
@@ -268,15 +586,41 @@ void cleanAll(board_t* board){
 	#pragma omp section
 	free(board->vectorWidth);	
 	}
+	if(board->step == FULL_MATRIX){
+	#pragma omp for private (n)
+	for(n = 0; n < board->numa.numNodes; n++){
+		munmap(board->numa.slab[n], board->numa.slabBytes[n]);
+	}
+	#pragma omp single
+	free(board->numa.threadNode);
+	}else{
+	#pragma omp for private (n)
+	for(n = 0; n < board->height / board->step + 1; n++){
+		free(board->checkpoints[n]);
+	}
 	#pragma omp for private (n)
-	for(n = 0; n < board->height; n++){
-		free(board->matrix[n]);
+	for(n = 0; n < board->numSlots; n++){
+		int r;
+		for(r = 0; r < board->step; r++){
+			free(board->slots[n][r]);
+		}
+		free(board->slots[n]);
+		free(board->slotMatrix[n]);
+	}
+	#pragma omp single
+	{
+	free(board->checkpoints);
+	free(board->slots);
+	free(board->slotMatrix);
+	}
 	}
 
+	if(board->fill == ROWS){
 	#pragma omp for private (n)
 	for(n = 0; n < ((board->height +1) * (board->width +1)); n++){
 		omp_destroy_lock(&(board->locks[n]));
 	}
+	}
 	
 	#pragma omp sections
 	{
@@ -324,3 +668,477 @@ void lockLine(int i, Board board){
 		omp_set_lock(&(board->locks[n + offset]));
 	}
 }
+
+/* Function that reads the memory budget
+ * LCS_MEM_BUDGET accepts a byte count with an optional K, M or G suffix
+ * returns the budget, the physical memory when it is not set
+ */
+size_t memoryBudget(){
+	char* value = getenv("LCS_MEM_BUDGET");
+	char* suffix;
+	double budget;
+
+	if (value == NULL || *value == '\0') {
+		return (size_t)sysconf(_SC_PHYS_PAGES) * (size_t)sysconf(_SC_PAGE_SIZE);
+	}
+	budget = strtod(value, &suffix);
+	switch (*suffix) {
+		case 'G': case 'g': budget *= 1024.0 * 1024 * 1024; break;
+		case 'M': case 'm': budget *= 1024.0 * 1024; break;
+		case 'K': case 'k': budget *= 1024.0; break;
+	}
+	return (size_t)budget;
+}
+
+/* Function that computes the peak memory of the board
+ * Counts the sequences, the matrix and one lock per cell for the row fill,
+ * or the checkpoint rows and one block of rows per slot
+ * height, width the sizes; fill, ROWS or RECURSIVE; step, the checkpoint step or FULL_MATRIX
+ * returns the peak in bytes
+ */
+size_t peakMemory(int height, int width, short fill, int step){
+	size_t cells = ((size_t)height + 1) * ((size_t)width + 1);
+	size_t rowBytes = sizeof(short int) * ((size_t)width + 1);
+	size_t slots = omp_get_max_threads();
+	size_t bytes = sizeof(board_t) + (size_t)height + 1 + (size_t)width + 1;
+
+	bytes += sizeof(short int*) * ((size_t)height + 1);
+	bytes += sizeof(char) * (size_t)(height < width ? height : width);
+	if (step == FULL_MATRIX) {
+		bytes += cells * sizeof(short int);
+		if (fill == ROWS) bytes += cells * sizeof(omp_lock_t);
+		return bytes;
+	}
+	bytes += ((size_t)height / step + 1) * (rowBytes + sizeof(short int*));
+	bytes += slots * ((size_t)step * (rowBytes + sizeof(short int*)) + sizeof(short int*) * ((size_t)height + 1));
+	return bytes;
+}
+
+/* Function that picks the engine before anything is allocated
+ * Keeps the full matrix when it fits the budget, otherwise, with the
+ * recursive fill, checkpoints every sqrt(height / threads) rows so each
+ * thread can recompute one block during the backtrack
+ * LCS_ENGINE set to full or checkpoint forces an engine
+ * Reports the plan on stderr and exits when nothing fits
+ * height, width the sizes; fill, ROWS or RECURSIVE
+ * returns the checkpoint step or FULL_MATRIX
+ */
+int planMemory(int height, int width, short fill){
+	size_t budget = memoryBudget();
+	size_t full = peakMemory(height, width, fill, FULL_MATRIX);
+	char* engine = getenv("LCS_ENGINE");
+	char* name = (fill == ROWS) ? "full matrix and locks" : "full matrix";
+	int step = (int)ceil(sqrt((double)height / omp_get_max_threads()));
+	size_t checkpointed;
+
+	if (step < 1) step = 1;
+	checkpointed = peakMemory(height, width, fill, step);
+	if (engine == NULL) engine = "";
+	if (*engine && strcmp(engine, "full") && strcmp(engine, "checkpoint")) {
+		fprintf(stderr, "Unknown LCS_ENGINE \"%s\", use full or checkpoint\n", engine);
+		exit(1);
+	}
+	if (!strcmp(engine, "full") || (!*engine && full <= budget)) {
+		fprintf(stderr, "plan: %s, peak %zu bytes, budget %zu bytes\n", name, full, budget);
+		return FULL_MATRIX;
+	}
+	if (fill == RECURSIVE && (!strcmp(engine, "checkpoint") || checkpointed <= budget)) {
+		fprintf(stderr, "plan: checkpoint every %d rows, %d blocks per backtrack round, peak %zu bytes (%s %zu), budget %zu bytes\n",
+		        step, omp_get_max_threads(), checkpointed, name, full, budget);
+		return step;
+	}
+	fprintf(stderr, "plan: %s need %zu bytes, budget %zu bytes, use %slcs-ooc\n",
+	        name, full, budget, (fill == ROWS) ? "the recursive fill or " : "");
+	exit(5);
+}
+
+/* Function that reads LCS_PERF and sets up the counters
+ * table or json turn the counters on, anything else leaves them off
+ * returns the counters, NULL when they are off
+ */
+Counters initCounters(){
+	char* format = getenv("LCS_PERF");
+	Counters counters;
+
+	if (format == NULL || *format == '\0') return NULL;
+	counters = (Counters)calloc(1, sizeof(counters_t));
+	if (!strcmp(format, "json")) {
+		counters->format = JSON;
+	} else if (!strcmp(format, "table")) {
+		counters->format = TABLE;
+	} else {
+		fprintf(stderr, "Unknown LCS_PERF \"%s\", use table or json\n", format);
+		exit(1);
+	}
+	counters->threads = omp_get_max_threads();
+	counters->fd = (int*)malloc(sizeof(int) * counters->threads * NUM_EVENTS);
+	counters->values = (long long*)malloc(sizeof(long long) * PHASES * counters->threads * NUM_EVENTS);
+	counters->available = 0;
+	return counters;
+}
+
+/* Function that opens one hardware counter on the calling thread
+ * Only user space is counted, so the default perf_event_paranoid works
+ * returns the file descriptor, -1 when the counter is not available
+ */
+int openCounter(unsigned long long config){
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/* Function that starts counting a phase on every thread of the team
+ * Each thread opens its own counters, so they follow that thread only
+ * counters, NULL when off; phase, PARSE, FILL or TRACEBACK
+ */
+void startPhase(Counters counters, int phase){
+	static const unsigned long long events[NUM_EVENTS] = {
+		PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+	};
+
+	if (counters == NULL) return;
+#pragma omp parallel num_threads(counters->threads)
+	{
+		int* fd = counters->fd + omp_get_thread_num() * NUM_EVENTS;
+		int e;
+		for (e = 0; e < NUM_EVENTS; e++) {
+			fd[e] = openCounter(events[e]);
+			if (fd[e] != -1) {
+				ioctl(fd[e], PERF_EVENT_IOC_RESET, 0);
+				ioctl(fd[e], PERF_EVENT_IOC_ENABLE, 0);
+			} else {
+#pragma omp atomic write
+				counters->error = errno;
+			}
+		}
+	}
+	counters->seconds[phase] = omp_get_wtime();
+}
+
+/* Function that stops a phase and keeps its counts
+ * Counts are scaled up when the kernel multiplexed the counter,
+ * a counter that could not be opened or read is kept as -1
+ * counters, NULL when off; phase, PARSE, FILL or TRACEBACK
+ */
+void stopPhase(Counters counters, int phase){
+	long long* values;
+	unsigned long long data[3];
+	int n;
+
+	if (counters == NULL) return;
+	counters->seconds[phase] = omp_get_wtime() - counters->seconds[phase];
+	values = counters->values + phase * counters->threads * NUM_EVENTS;
+	for (n = 0; n < counters->threads * NUM_EVENTS; n++) {
+		values[n] = -1;
+		if (counters->fd[n] == -1) continue;
+		ioctl(counters->fd[n], PERF_EVENT_IOC_DISABLE, 0);
+		if (read(counters->fd[n], data, sizeof(data)) == sizeof(data) && data[2] > 0) {
+			values[n] = (data[2] < data[1]) ? (long long)((double)data[0] * data[1] / data[2]) : (long long)data[0];
+			counters->available = 1;
+		}
+		close(counters->fd[n]);
+	}
+}
+
+/* Function that prints one count, - or null when it's missing
+ */
+void printCount(long long value, short format){
+	if (format == JSON) {
+		if (value < 0) fprintf(stderr, "null");
+		else fprintf(stderr, "%lld", value);
+	} else {
+		if (value < 0) fprintf(stderr, " %14s", "-");
+		else fprintf(stderr, " %14lld", value);
+	}
+}
+
+/* Prints the counters of every phase and thread on stderr
+ * as a table or as one JSON object, and frees them
+ * IPC and misses per thousand instructions tell a compute bound fill
+ * from a memory bound one
+ */
+void printCounters(Counters counters){
+	static const char* phaseNames[PHASES] = {"parse", "fill", "traceback"};
+	static const char* eventNames[NUM_EVENTS] = {"cycles", "instructions", "cache-misses", "branch-misses"};
+	long long* values;
+	int phase, thread, e;
+
+	if (counters == NULL) return;
+	if (!counters->available) {
+		fprintf(stderr, "perf: hardware counters unavailable (%s)\n", strerror(counters->error));
+	}
+	if (counters->format == JSON) {
+		fprintf(stderr, "{\"threads\": %d, \"available\": %s, \"phases\": [", counters->threads,
+		        counters->available ? "true" : "false");
+		for (phase = 0; phase < PHASES; phase++) {
+			values = counters->values + phase * counters->threads * NUM_EVENTS;
+			fprintf(stderr, "%s{\"phase\": \"%s\", \"seconds\": %.6f, \"threads\": [", phase ? ", " : "",
+			        phaseNames[phase], counters->seconds[phase]);
+			for (thread = 0; thread < counters->threads; thread++) {
+				fprintf(stderr, "%s{\"thread\": %d", thread ? ", " : "", thread);
+				for (e = 0; e < NUM_EVENTS; e++) {
+					fprintf(stderr, ", \"%s\": ", eventNames[e]);
+					printCount(values[thread * NUM_EVENTS + e], JSON);
+				}
+				fprintf(stderr, "}");
+			}
+			fprintf(stderr, "]}");
+		}
+		fprintf(stderr, "]}\n");
+	} else {
+		fprintf(stderr, "%-10s %6s %10s", "phase", "thread", "seconds");
+		for (e = 0; e < NUM_EVENTS; e++) fprintf(stderr, " %14s", eventNames[e]);
+		fprintf(stderr, " %6s %8s\n", "IPC", "miss/ki");
+		for (phase = 0; phase < PHASES; phase++) {
+			values = counters->values + phase * counters->threads * NUM_EVENTS;
+			for (thread = 0; thread < counters->threads; thread++) {
+				long long* count = values + thread * NUM_EVENTS;
+				fprintf(stderr, "%-10s %6d %10.3f", phaseNames[phase], thread, counters->seconds[phase]);
+				for (e = 0; e < NUM_EVENTS; e++) printCount(count[e], TABLE);
+				if (count[0] > 0 && count[1] >= 0) fprintf(stderr, " %6.2f", (double)count[1] / count[0]);
+				else fprintf(stderr, " %6s", "-");
+				if (count[1] > 0 && count[2] >= 0) fprintf(stderr, " %8.2f\n", 1000.0 * count[2] / count[1]);
+				else fprintf(stderr, " %8s\n", "-");
+			}
+		}
+	}
+	free(counters->fd);
+	free(counters->values);
+	free(counters);
+}
+
+/* Function that reads a kernel cpu list, like "0-3,8-11"
+ * returns the number of cpus in it
+ */
+int parseCpuList(char* list, cpu_set_t* cpus){
+	char* next = list;
+	long first, last, cpu;
+	int count = 0;
+
+	CPU_ZERO(cpus);
+	while (*next != '\0' && *next != '\n') {
+		first = strtol(next, &next, 10);
+		last = (*next == '-') ? strtol(next + 1, &next, 10) : first;
+		for (cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+			CPU_SET(cpu, cpus);
+			count++;
+		}
+		if (*next == ',') next++;
+		else if (*next != '\0' && *next != '\n') break;
+	}
+	return count;
+}
+
+/* Function that finds the NUMA nodes the threads can run on
+ * Nodes come from /sys/devices/system/node, limited to the cpus the
+ * process may use, and threads are spread over them in contiguous
+ * groups; with more than one node each thread is pinned to its node
+ * unless LCS_PIN=0, or OMP_PROC_BIND already places the threads
+ */
+void initNuma(numa_t* numa){
+	char path[128], list[4096];
+	char* pin = getenv("LCS_PIN");
+	char* huge = getenv("LCS_HUGEPAGES");
+	cpu_set_t allowed;
+	FILE* file;
+	int threads = omp_get_max_threads();
+	int node, t;
+
+	sched_getaffinity(0, sizeof(allowed), &allowed);
+	numa->numNodes = 0;
+	for (node = 0; node < MAX_NODES; node++) {
+		sprintf(path, "/sys/devices/system/node/node%d/cpulist", node);
+		if (!(file = fopen(path, "r"))) continue;
+		if (fgets(list, sizeof(list), file) && parseCpuList(list, &numa->cpus[numa->numNodes])) {
+			CPU_AND(&numa->cpus[numa->numNodes], &numa->cpus[numa->numNodes], &allowed);
+			if (CPU_COUNT(&numa->cpus[numa->numNodes]) > 0) {
+				numa->nodeId[numa->numNodes++] = node;
+			}
+		}
+		fclose(file);
+	}
+	if (numa->numNodes == 0) {
+		numa->numNodes = 1;
+		numa->nodeId[0] = 0;
+		numa->cpus[0] = allowed;
+	}
+	numa->numNodes = MIN(numa->numNodes, threads);
+	numa->threadNode = (int*)malloc(sizeof(int) * threads);
+	for (t = 0; t < threads; t++) {
+		numa->threadNode[t] = t * numa->numNodes / threads;
+	}
+	numa->hugePages = (huge != NULL && *huge != '\0' && strcmp(huge, "0"));
+	numa->pinned = numa->numNodes > 1 && !(pin != NULL && !strcmp(pin, "0")) &&
+	               omp_get_proc_bind() == omp_proc_bind_false;
+	if (numa->pinned) {
+#pragma omp parallel num_threads(threads)
+		sched_setaffinity(0, sizeof(cpu_set_t), &numa->cpus[numa->threadNode[omp_get_thread_num()]]);
+	}
+}
+
+/* Function that tells which thread owns a row of the matrix
+ * With the row fill it is the thread that computes the row,
+ * with the recursive fill the rows of a node band are split
+ * between the threads of that node
+ */
+int rowOwner(int i, Board board){
+	numa_t* numa = &board->numa;
+	int threads = omp_get_max_threads();
+	int node, first, count;
+
+	if (board->fill == ROWS) return i % threads;
+	for (node = 0; i >= numa->firstRow[node + 1]; node++);
+	first = (node * threads + numa->numNodes - 1) / numa->numNodes;
+	count = ((node + 1) * threads + numa->numNodes - 1) / numa->numNodes - first;
+	return first + (int)((long)(i - numa->firstRow[node]) * count / (numa->firstRow[node + 1] - numa->firstRow[node]));
+}
+
+/* Function that allocates the rows of the matrix node by node
+ * Each node gets one mapping for the rows its threads own, bound to
+ * the node and optionally backed by huge pages, and every row is first
+ * touched by its owner so the pages land where they will be used
+ * board, the current board, the matrix array already allocated
+ */
+void allocMatrix(Board board){
+	numa_t* numa = &board->numa;
+	size_t rowBytes = sizeof(short int) * (board->width + 1);
+	size_t pageSize = (size_t)sysconf(_SC_PAGE_SIZE);
+	int used[MAX_NODES];
+	int threads = omp_get_max_threads();
+	unsigned long mask;
+	int i, node;
+
+	initNuma(numa);
+	for (node = 0; node <= numa->numNodes; node++) {
+		numa->firstRow[node] = (int)((long)node * (board->height + 1) / numa->numNodes);
+	}
+	for (node = 0; node < numa->numNodes; node++) numa->rows[node] = used[node] = 0;
+	for (i = 0; i <= board->height; i++) numa->rows[numa->threadNode[rowOwner(i, board)]]++;
+
+	for (node = 0; node < numa->numNodes; node++) {
+		numa->slabBytes[node] = MAX((numa->rows[node] * rowBytes + pageSize - 1) / pageSize * pageSize, pageSize);
+		numa->slab[node] = (short int*)mmap(NULL, numa->slabBytes[node], PROT_READ | PROT_WRITE,
+		                                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (numa->slab[node] == MAP_FAILED) {
+			printf("Error allocating row pointers for board.\n");
+			exit(4);
+		}
+		if (numa->numNodes > 1 && numa->nodeId[node] < 8 * (int)sizeof(mask)) {
+			mask = 1UL << numa->nodeId[node];
+			syscall(SYS_mbind, numa->slab[node], numa->slabBytes[node], MPOL_PREFERRED, &mask, 8 * sizeof(mask), 0);
+		}
+		if (numa->hugePages) madvise(numa->slab[node], numa->slabBytes[node], MADV_HUGEPAGE);
+	}
+	for (i = 0; i <= board->height; i++) {
+		node = numa->threadNode[rowOwner(i, board)];
+		board->matrix[i] = (short int*)((char*)numa->slab[node] + rowBytes * used[node]++);
+	}
+#pragma omp parallel num_threads(threads) private(i)
+	{
+		int thread = omp_get_thread_num();
+		for (i = 0; i <= board->height; i++) {
+			if (rowOwner(i, board) == thread) memset(board->matrix[i], 0, rowBytes);
+		}
+	}
+}
+
+/* Recursive fill with one team of threads per NUMA node
+ * Node k fills its band of rows BLOCK_COLUMNS columns at a time,
+ * as soon as node k-1 has finished the same columns above it,
+ * so every node works on the rows in its own memory
+ * board, the current board
+ */
+void fillNodes(Board board){
+	numa_t* numa = &board->numa;
+	int threads = omp_get_max_threads();
+	int blocks = board->width / BLOCK_COLUMNS + 1;
+	int* done = (int*)calloc(numa->numNodes, sizeof(int));
+
+	omp_set_max_active_levels(2);
+#pragma omp parallel num_threads(numa->numNodes)
+	{
+		int node = omp_get_thread_num();
+		int first = (node * threads + numa->numNodes - 1) / numa->numNodes;
+		int count = ((node + 1) * threads + numa->numNodes - 1) / numa->numNodes - first;
+		int block, ready;
+		double start;
+
+		numa->seconds[node] = 0;
+		for (block = 0; block < blocks; block++) {
+			if (node > 0) {
+				do {
+#pragma omp atomic read seq_cst
+					ready = done[node - 1];
+					if (ready <= block) sched_yield();
+				} while (ready <= block);
+				/* the cells of the node above must be seen before they are read */
+#pragma omp flush
+			}
+			start = omp_get_wtime();
+#pragma omp parallel num_threads(count)
+			{
+				if (numa->pinned) sched_setaffinity(0, sizeof(cpu_set_t), &numa->cpus[node]);
+#pragma omp single
+				fillRecursive(numa->firstRow[node], numa->firstRow[node + 1] - 1, block * BLOCK_COLUMNS,
+				              MIN((block + 1) * BLOCK_COLUMNS - 1, board->width), board->matrix, board);
+			}
+			numa->seconds[node] += omp_get_wtime() - start;
+#pragma omp flush
+#pragma omp atomic write seq_cst
+			done[node] = block + 1;
+		}
+	}
+	free(done);
+}
+
+/* Function that checks where the pages of a node's rows ended up
+ * returns the fraction of the pages on nodeId, -1 if it can't be told
+ */
+double localPages(short int* slab, size_t bytes, int nodeId){
+	size_t pageSize = (size_t)sysconf(_SC_PAGE_SIZE);
+	size_t pages = bytes / pageSize, stride = pages / 1024 + 1, n, count = 0, local = 0;
+	void* addresses[1024];
+	int status[1024];
+
+	for (n = 0; n < pages && count < 1024; n += stride) {
+		addresses[count++] = (char*)slab + n * pageSize;
+	}
+	if (syscall(SYS_move_pages, 0, count, addresses, NULL, status, 0) != 0) return -1;
+	for (n = 0; n < count; n++) {
+		if (status[n] == nodeId) local++;
+	}
+	return count ? (double)local / count : -1;
+}
+
+/* Prints on stderr, for every node, the rows it owns, how long its
+ * threads filled them and the bandwidth of those writes,
+ * and how many of its pages are really on the node
+ * Only runs with LCS_REPORT=numa, sampling the pages takes a syscall
+ * board, the current board; seconds, the time of the whole fill
+ */
+void printNuma(Board board, double seconds){
+	numa_t* numa = &board->numa;
+	double bytes, busy, local;
+	int node;
+
+	if (board->step != FULL_MATRIX) return;
+	for (node = 0; node < numa->numNodes; node++) {
+		bytes = (double)numa->rows[node] * (board->width + 1) * sizeof(short int);
+		busy = (numa->numNodes > 1 && board->fill == RECURSIVE) ? numa->seconds[node] : seconds;
+		local = localPages(numa->slab[node], numa->slabBytes[node], numa->nodeId[node]);
+		fprintf(stderr, "numa: node %d, %d rows, %.1f MB, %.3f s, %.1f MB/s, ", numa->nodeId[node], numa->rows[node],
+		        bytes / 1e6, busy, busy > 0 ? bytes / 1e6 / busy : 0.0);
+		if (local < 0) fprintf(stderr, "locality unknown");
+		else fprintf(stderr, "%.0f%% local", 100 * local);
+		fprintf(stderr, "%s%s\n", numa->pinned ? ", pinned" : "", numa->hugePages ? ", huge pages" : "");
+	}
+}
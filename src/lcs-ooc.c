@@ -0,0 +1,415 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#define MAX(x, y) ( ((x) > (y)) ? (x) : (y) )
+#define MIN(x, y) ( ((x) > (y)) ? (y) : (x) )
+
+#define DEFAULT_TILE 1024
+#define IO_BUFFER (8 << 20)
+
+#define BITS 0		//every delta is 0 or 1, one bit each
+#define BYTES 1		//one byte per delta, 255 escapes to a full int
+
+/* Out-of-core board: only the bottom row of the current band and the
+ * right column of the current tile are in memory, the top row segment
+ * and the left column of every tile are spilled compressed to a scratch
+ * file, band after band, and read back one band at a time for the backtrack
+ * Values are int, million-symbol inputs overflow short
+ */
+typedef struct {
+	int height;
+	int width;
+	char* vectorHeight;
+	char* vectorWidth;
+	short* costTable;
+	int tile;
+	int bands;
+	int tilesPerBand;
+	FILE* scratch;
+	long* bandOffsets;	//bands + 1 offsets in the scratch file
+	long* topOffsets;	//one per tile, from the start of its band
+	long* leftOffsets;
+	int* row;		//width + 1
+	int finalSize;
+}board_t;
+
+typedef board_t* Board;
+
+short cost(int x);
+Board parseFile(char* fileName);
+FILE* openScratch();
+long encodeBoundary(int* values, int length, FILE* file);
+void decodeBoundary(unsigned char* data, int* values, int length);
+void processTile(int i0, int i1, int j0, int j1, int** tile, Board board);
+void iterateBoard(board_t* board);
+unsigned char* readBand(int band, Board board);
+void loadTile(int band, int column, unsigned char* data, int** tile, Board board);
+void printResults(board_t* board);
+void cleanAll(board_t* board);
+
+int main(int argc, char* argv[]){
+
+	char* fileName = argv[1];
+	Board board = parseFile(fileName);
+	iterateBoard(board);
+	printResults(board);
+	cleanAll(board);
+	return 0;
+}
+
+/* Opens an unlinked scratch file in LCS_SCRATCH (or /tmp)
+ * The file goes away with the process
+ */
+FILE* openScratch(){
+	char* dir = getenv("LCS_SCRATCH");
+	char path[4096];
+	FILE* file;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/lcs-ooc-XXXXXX", (dir && *dir) ? dir : "/tmp");
+	if((fd = mkstemp(path)) < 0 || !(file = fdopen(fd, "w+b"))){
+		printf("Error creating scratch file in \"%s\"\n", (dir && *dir) ? dir : "/tmp");
+		exit(5);
+	}
+	unlink(path);
+	setvbuf(file, NULL, _IOFBF, IO_BUFFER);
+	return file;
+}
+
+/* Writes a monotone boundary as its first value and the deltas
+ * Unit deltas are packed one bit each, others one byte with an escape
+ * values, the boundary; length, its size; file, the scratch file
+ * returns the bytes written
+ */
+long encodeBoundary(int* values, int length, FILE* file){
+	unsigned char mode = BITS;
+	unsigned char byte = 0;
+	int n, delta;
+	long bytes = 1 + sizeof(int);
+
+	for(n = 1; n < length; n++){
+		delta = values[n] - values[n - 1];
+		if(delta != 0 && delta != 1) mode = BYTES;
+	}
+	fputc(mode, file);
+	fwrite(&values[0], sizeof(int), 1, file);
+
+	for(n = 1; n < length; n++){
+		delta = values[n] - values[n - 1];
+		if(mode == BITS){
+			byte |= delta << ((n - 1) % 8);
+			if((n - 1) % 8 == 7 || n == length - 1){
+				fputc(byte, file);
+				byte = 0;
+				bytes++;
+			}
+		}else if(delta >= 0 && delta < 255){
+			fputc(delta, file);
+			bytes++;
+		}else{
+			fputc(255, file);
+			fwrite(&values[n], sizeof(int), 1, file);
+			bytes += 1 + sizeof(int);
+		}
+	}
+	return bytes;
+}
+
+/* Reads back a boundary written by encodeBoundary
+ * data, the encoded bytes; values, where to decode; length, its size
+ */
+void decodeBoundary(unsigned char* data, int* values, int length){
+	unsigned char mode = *data++;
+	int n;
+
+	memcpy(&values[0], data, sizeof(int));
+	data += sizeof(int);
+	for(n = 1; n < length; n++){
+		if(mode == BITS){
+			values[n] = values[n - 1] + ((data[(n - 1) / 8] >> ((n - 1) % 8)) & 1);
+		}else if(*data != 255){
+			values[n] = values[n - 1] + *data++;
+		}else{
+			memcpy(&values[n], data + 1, sizeof(int));
+			data += 1 + sizeof(int);
+		}
+	}
+}
+
+/* Function that fills a tile whose row 0 and column 0 hold its boundaries
+ * Same recurrence as processCell
+ * i0, i1, j0, j1 the matrix rows and columns of the tile
+ */
+void processTile(int i0, int i1, int j0, int j1, int** tile, Board board){
+	int i, j, r, c;
+
+	for(i = i0, r = 1; i <= i1; i++, r++){
+		for(j = j0, c = 1; j <= j1; j++, c++){
+			if(board->vectorHeight[i] == board->vectorWidth[j]){
+				tile[r][c] = tile[r - 1][c - 1] + board->costTable[i + j];
+			}else{
+				tile[r][c] = MAX(tile[r - 1][c], tile[r][c - 1]);
+			}
+		}
+	}
+}
+
+/* Function that iterates through the matrix band by band, tile by tile
+ * Spills the top segment of every tile when its band starts and its
+ * left column before it is filled, then keeps only its outputs
+ */
+void iterateBoard(board_t* board){
+	int height = board->height;
+	int width = board->width;
+	int T = board->tile;
+	int** tile = (int**)malloc(sizeof(int*) * (T + 1));
+	int* left = (int*)malloc(sizeof(int) * (T + 1));
+	int band, column, i0, i1, j0, j1, r, c, corner, nextCorner;
+	long offset;
+
+	for(r = 0; r <= T; r++){
+		tile[r] = (int*)malloc(sizeof(int) * (T + 1));
+	}
+	board->bandOffsets[0] = 0;
+
+	for(band = 0; band < board->bands; band++){
+		i0 = band * T + 1;
+		i1 = MIN(i0 + T - 1, height);
+		offset = 0;
+
+		for(column = 0; column < board->tilesPerBand; column++){
+			j0 = column * T + 1;
+			j1 = MIN(j0 + T - 1, width);
+			board->topOffsets[band * board->tilesPerBand + column] = offset;
+			offset += encodeBoundary(&board->row[j0 - 1], j1 - j0 + 2, board->scratch);
+		}
+
+		for(r = 0; r <= i1 - i0 + 1; r++) left[r] = 0;
+		corner = 0;
+		for(column = 0; column < board->tilesPerBand; column++){
+			j0 = column * T + 1;
+			j1 = MIN(j0 + T - 1, width);
+			nextCorner = board->row[j1];
+			left[0] = corner;
+			board->leftOffsets[band * board->tilesPerBand + column] = offset;
+			offset += encodeBoundary(left, i1 - i0 + 2, board->scratch);
+
+			for(c = 1; c <= j1 - j0 + 1; c++) tile[0][c] = board->row[j0 - 1 + c];
+			for(r = 0; r <= i1 - i0 + 1; r++) tile[r][0] = left[r];
+			processTile(i0, i1, j0, j1, tile, board);
+			for(r = 0; r <= i1 - i0 + 1; r++) left[r] = tile[r][j1 - j0 + 1];
+			/* row[j0-1] already holds the bottom of the previous tile */
+			for(c = 1; c <= j1 - j0 + 1; c++) board->row[j0 - 1 + c] = tile[i1 - i0 + 1][c];
+			corner = nextCorner;
+		}
+		board->bandOffsets[band + 1] = board->bandOffsets[band] + offset;
+	}
+	fflush(board->scratch);
+	board->finalSize = board->row[width];
+
+	for(r = 0; r <= T; r++){
+		free(tile[r]);
+	}
+	free(tile);
+	free(left);
+}
+
+/* Reads the boundaries of a whole band with one sequential read
+ * returns the encoded band
+ */
+unsigned char* readBand(int band, Board board){
+	long size = board->bandOffsets[band + 1] - board->bandOffsets[band];
+	unsigned char* data = (unsigned char*)malloc(size);
+
+	if(fseek(board->scratch, board->bandOffsets[band], SEEK_SET) ||
+	   fread(data, 1, size, board->scratch) != size){
+		printf("Error reading scratch file\n");
+		exit(5);
+	}
+	return data;
+}
+
+/* Function that recomputes one tile from its spilled boundaries
+ * band, column the tile; data, its encoded band; tile, the tile buffer
+ */
+void loadTile(int band, int column, unsigned char* data, int** tile, Board board){
+	int T = board->tile;
+	int i0 = band * T + 1;
+	int i1 = MIN(i0 + T - 1, board->height);
+	int j0 = column * T + 1;
+	int j1 = MIN(j0 + T - 1, board->width);
+	int* left = (int*)malloc(sizeof(int) * (T + 1));
+	int r;
+
+	decodeBoundary(data + board->topOffsets[band * board->tilesPerBand + column], tile[0], j1 - j0 + 2);
+	decodeBoundary(data + board->leftOffsets[band * board->tilesPerBand + column], left, i1 - i0 + 2);
+	for(r = 0; r <= i1 - i0 + 1; r++) tile[r][0] = left[r];
+	processTile(i0, i1, j0, j1, tile, board);
+	free(left);
+}
+
+/* Function that backtracks the matrix and fills the subsequence
+ * Recomputes only the tiles the path goes through, from the bottom right
+ * Applies the same backtracking rules as lcs-serial
+ * Prints out the final output
+ * board, the current board
+ */
+void printResults(board_t* board){
+	int T = board->tile;
+	int heightLength = board->height;
+	int widthLength = board->width;
+	int aux, finalSize = board->finalSize;
+	int band = -1, column = -1, i0 = 0, j0 = 0, r, c;
+	char* subsequence = (char*) malloc(sizeof(char) * (finalSize + 1));
+	unsigned char* data = NULL;
+	int** tile = (int**)malloc(sizeof(int*) * (T + 1));
+
+	for(r = 0; r <= T; r++){
+		tile[r] = (int*)malloc(sizeof(int) * (T + 1));
+	}
+
+	aux = finalSize;
+	while(aux > 0){
+		if((heightLength - 1) / T != band || (widthLength - 1) / T != column){
+			if((heightLength - 1) / T != band){
+				band = (heightLength - 1) / T;
+				free(data);
+				data = readBand(band, board);
+			}
+			column = (widthLength - 1) / T;
+			loadTile(band, column, data, tile, board);
+			i0 = band * T + 1;
+			j0 = column * T + 1;
+		}
+		r = heightLength - i0 + 1;
+		c = widthLength - j0 + 1;
+
+		if((tile[r-1][c] != aux) &&
+		   (tile[r][c-1] != aux)){
+			subsequence[aux -1] = board->vectorHeight[heightLength];
+			heightLength--;
+			widthLength--;
+			aux--;
+		}else if (board->vectorHeight[heightLength] == board->vectorWidth[widthLength]) {
+			subsequence[aux -1] = board->vectorHeight[heightLength];
+			heightLength--;
+			widthLength--;
+			aux--;
+		}else if (tile[r][c-1] == aux) {
+			widthLength--;
+		}else if (tile[r-1][c] == aux) {
+			heightLength--;
+		}
+	}
+	subsequence[finalSize] = '\0';
+	printf("%d\n", finalSize);
+	fwrite(subsequence, sizeof(char), finalSize, stdout);
+	printf("\n");
+
+	for(r = 0; r <= T; r++){
+		free(tile[r]);
+	}
+	free(tile);
+	free(data);
+	free(subsequence);
+}
+
+/* Function that reads the file and builds the board
+ * Builds the vertical and horizontal string, the cost table,
+ * the bottom row and the scratch file index
+ * filename, the name of the file to be read
+ * returns the board
+ */
+Board parseFile(char* fileName){
+	FILE* file;
+	int height;
+	int width;
+	int c, tile;
+	char* vectorHeight;
+	char* vectorWeidth;
+	char* tileSize = getenv("LCS_OOC_TILE");
+	size_t n = 1;
+
+
+	if (!(file = fopen(fileName,"r"))){
+	    printf("Error opening file \"%s\"\n", fileName);
+	    exit(2);
+	}
+	if(fscanf(file, "%d %d\n", &height, &width) == 0){
+	    printf("Could not read height and width");
+	    exit(3);
+	}
+	if(!(vectorHeight = (char*) malloc(sizeof(char)*(height + 1)))||
+	   !(vectorWeidth = (char*) malloc(sizeof(char)*(width + 1)))){
+		    printf("Error allocating row pointers for board.\n");
+		    exit(4);
+	}
+
+	while((c = fgetc(file)) != '\n'){
+		 vectorHeight[n++] = (char)c;
+	}
+	vectorHeight[0] = '/';
+
+	n = 1;
+	while((c = fgetc(file)) != '\n'){
+		vectorWeidth[n++] = (char)c;
+	}
+	vectorWeidth[0] = '/';
+	fclose(file);
+	file = NULL;
+
+	tile = (tileSize != NULL && atoi(tileSize) > 0) ? atoi(tileSize) : DEFAULT_TILE;
+
+	Board result = (Board)malloc(sizeof(board_t));
+
+	result->height =  height;
+	result->width = width;
+	result->vectorHeight = vectorHeight;
+	result->vectorWidth = vectorWeidth;
+	result->tile = tile;
+	result->bands = (height + tile - 1) / tile;
+	result->tilesPerBand = (width + tile - 1) / tile;
+	result->costTable = (short*)malloc(sizeof(short) * (height + width + 1));
+	for(n = 0; n < height + width + 1; n++){
+		result->costTable[n] = cost(n);
+	}
+	result->row = (int*)calloc(width + 1, sizeof(int));
+	result->bandOffsets = (long*)malloc(sizeof(long) * (result->bands + 1));
+	result->topOffsets = (long*)malloc(sizeof(long) * ((size_t)result->bands * result->tilesPerBand + 1));
+	result->leftOffsets = (long*)malloc(sizeof(long) * ((size_t)result->bands * result->tilesPerBand + 1));
+	result->scratch = openScratch();
+	result->finalSize = 0;
+
+	return result;
+
+}
+
+/* Function to add computation time
+ * returns 1 always
+ */
+short cost(int x){
+	int i, n_iter = 20;
+	double dcost = 0;
+	for(i = 0; i < n_iter; i++)
+		dcost += pow(sin((double) x),2) + pow(cos((double) x),2);
+	return (short) (dcost / n_iter + 0.1);
+}
+
+/*
+ * Clears the resourses used
+ */
+void cleanAll(board_t* board){
+
+	fclose(board->scratch);
+	free(board->vectorHeight);
+	free(board->vectorWidth);
+	free(board->costTable);
+	free(board->row);
+	free(board->bandOffsets);
+	free(board->topOffsets);
+	free(board->leftOffsets);
+	free(board);
+}
@@ -0,0 +1,463 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#define MAX(x, y) ( ((x) > (y)) ? (x) : (y) )
+#define MIN(x, y) ( ((x) > (y)) ? (y) : (x) )
+
+#define RUNS 0			//block boundaries
+#define DIRECTIONS 1		//two rows and 2 bits per cell, when the runs are too short
+
+#define DIAGONAL 0
+#define LEFT 1
+#define UP 2
+
+/* Run-length board: each sequence is kept as runs of one character, and
+ * the matrix is split in blocks, one per pair of runs
+ * Inside a block of different characters every cell is the max of the
+ * top boundary up to its column and the left boundary up to its row, a
+ * match does not take the max of its neighbours, so with weighted costs
+ * the boundaries are not sorted and their prefix maxima are kept too;
+ * inside a block
+ * of the same character every cell is a match, so it is the boundary cell
+ * down its diagonal plus the costs along the way
+ * Only the bottom row of every band of runs and the right column of every
+ * block are stored, any other cell is rebuilt from them in O(1)
+ * When that takes more than the 2-bit moves of every cell, the runs are
+ * expanded and filled as lcs-serial does in its directions engine
+ */
+typedef struct {
+	int height;
+	int width;
+	int runsHeight;
+	int runsWidth;
+	char* charHeight;	//1-based, one character per run
+	char* charWidth;
+	int* startHeight;	//first index of each run, startHeight[runsHeight + 1] = height + 1
+	int* startWidth;
+	short* costTable;	//cost(i + j)
+	int* costSum;		//costSum[n] = cost(n) + cost(n - 2) + ..., sums along a diagonal
+	int* rows;		//(runsHeight + 1) rows of width + 1, bottom row of each band
+	int* rowsMax;		//max of rows from the first column of the block
+	int** columns;		//columns[p], runsWidth + 1 right columns of the band, column 0 is zero
+	int** columnsMax;	//max of columns from the first row of the band
+	short engine;		//RUNS or DIRECTIONS
+	char* vectorHeight;	//expanded runs, DIRECTIONS only
+	char* vectorWidth;
+	unsigned char* directions;	//4 cells per byte, row major, DIRECTIONS only
+	char* subsequence;
+	int size;
+	int finalSize;
+}board_t;
+
+typedef board_t* Board;
+
+short cost(int x);
+Board parseFile(char* fileName);
+int readRuns(FILE* file, int length, char** chars, int** starts);
+size_t memoryBudget();
+size_t peakMemory(Board board);
+size_t directionsMemory(int height, int width);
+char* expandRuns(char* chars, int* starts, int runs, int length);
+void iterateDirections(board_t* board);
+void backtrackDirections(board_t* board);
+int blockCell(int p, int q, int x, int y, Board board);
+int cellValue(int i, int j, int p, int q, Board board);
+void iterateBoard(board_t* board);
+void printResults(board_t* board);
+void cleanAll(board_t* board);
+
+int main(int argc, char* argv[]){
+
+	char* fileName = argv[1];
+	Board board = parseFile(fileName);
+	iterateBoard(board);
+	printResults(board);
+	cleanAll(board);
+	return 0;
+}
+
+/* Value of cell (x, y) of block (p, q), counted from the block corner
+ * Reads the bottom row of band p - 1 and the right column of block q - 1
+ */
+int blockCell(int p, int q, int x, int y, Board board){
+	size_t topOffset = (size_t)(p - 1) * (board->width + 1);
+	size_t leftOffset = (size_t)(q - 1) * (board->startHeight[p + 1] - board->startHeight[p] + 1);
+	int* top = board->rows + topOffset;
+	int* left = board->columns[p] + leftOffset;
+	int i = board->startHeight[p] - 1 + x;
+	int j = board->startWidth[q] - 1 + y;
+	int t = MIN(x, y);
+
+	if (board->charHeight[p] != board->charWidth[q]) {
+		return MAX(board->rowsMax[topOffset + j], board->columnsMax[p][leftOffset + x]);
+	}
+	return ((x <= y) ? top[j - x] : left[x - y]) + board->costSum[i + j] - board->costSum[i + j - 2 * t];
+}
+
+/* Value of cell (i, j) of the matrix
+ * p, q the runs of i and j or the ones after them
+ */
+int cellValue(int i, int j, int p, int q, Board board){
+	if (i == 0 || j == 0) return 0;
+	if (board->startHeight[p] > i) p--;
+	if (board->startWidth[q] > j) q--;
+	return blockCell(p, q, i - board->startHeight[p] + 1, j - board->startWidth[q] + 1, board);
+}
+
+/* Function that iterates through the blocks
+ * Each block fills its right column and bottom row, O(runs of width *
+ * height + runs of height * width) in all, instead of height * width
+ * board, the current board
+ */
+void iterateBoard(board_t* board){
+	int p, q, x, y, j, lengthHeight, lengthWidth;
+	int *row, *rowMax, *column, *columnMax;
+
+	if (board->engine == DIRECTIONS) {
+		iterateDirections(board);
+		return;
+	}
+	for (p = 1; p <= board->runsHeight; ++p) {
+		lengthHeight = board->startHeight[p + 1] - board->startHeight[p];
+		row = board->rows + (size_t)p * (board->width + 1);
+		rowMax = board->rowsMax + (size_t)p * (board->width + 1);
+		for (q = 1; q <= board->runsWidth; ++q) {
+			lengthWidth = board->startWidth[q + 1] - board->startWidth[q];
+			column = board->columns[p] + (size_t)q * (lengthHeight + 1);
+			columnMax = board->columnsMax[p] + (size_t)q * (lengthHeight + 1);
+			for (x = 1; x <= lengthHeight; ++x) {
+				column[x] = blockCell(p, q, x, lengthWidth, board);
+				columnMax[x] = (x == 1) ? column[x] : MAX(columnMax[x - 1], column[x]);
+			}
+			for (y = 1; y <= lengthWidth; ++y) {
+				j = board->startWidth[q] - 1 + y;
+				row[j] = blockCell(p, q, lengthHeight, y, board);
+				rowMax[j] = (y == 1) ? row[j] : MAX(rowMax[j - 1], row[j]);
+			}
+		}
+	}
+	board->finalSize = board->rows[(size_t)board->runsHeight * (board->width + 1) + board->width];
+}
+
+/* Function that fills the expanded sequences with two rows of values and
+ * the 2-bit move of every cell, the moves of lcs-serial
+ * board, the current board
+ */
+void iterateDirections(board_t* board){
+	size_t columns = (size_t)board->width + 1;
+	short* previous = (short*)calloc(columns, sizeof(short));
+	short* current = (short*)calloc(columns, sizeof(short));
+	short *aux, value;
+	size_t cell;
+	int i, j, direction;
+
+	if (previous == NULL || current == NULL) {
+		printf("Error allocating row pointers for board.\n");
+		exit(4);
+	}
+	for (i = 1; i <= board->height; i++) {
+		for (j = 1; j <= board->width; j++) {
+			if (board->vectorHeight[i] == board->vectorWidth[j]) {
+				value = previous[j - 1] + board->costTable[i + j];
+			} else {
+				value = MAX(previous[j], current[j - 1]);
+			}
+			current[j] = value;
+			if ((previous[j] != value) && (current[j - 1] != value)) {
+				direction = DIAGONAL;
+			} else if (board->vectorHeight[i] == board->vectorWidth[j]) {
+				direction = DIAGONAL;
+			} else if (current[j - 1] == value) {
+				direction = LEFT;
+			} else {
+				direction = UP;
+			}
+			cell = (size_t)i * columns + j;
+			board->directions[cell / 4] |= direction << (2 * (cell % 4));
+		}
+		aux = previous;
+		previous = current;
+		current = aux;
+	}
+	board->finalSize = previous[board->width];
+	free(previous);
+	free(current);
+}
+
+/* Function that follows the moves back from the bottom right cell,
+ * the characters come out backwards as in the block backtrack
+ * board, the current board
+ */
+void backtrackDirections(board_t* board){
+	size_t columns = (size_t)board->width + 1, cell;
+	int i = board->height, j = board->width, aux = board->finalSize;
+
+	while (aux > 0) {
+		cell = (size_t)i * columns + j;
+		switch ((board->directions[cell / 4] >> (2 * (cell % 4))) & 3) {
+			case DIAGONAL:
+				board->subsequence[board->size++] = board->vectorHeight[i];
+				aux -= board->costTable[i + j];
+				i--;
+				j--;
+				break;
+			case LEFT:
+				j--;
+				break;
+			default:
+				i--;
+		}
+	}
+}
+
+/* Function that reads one sequence as runs
+ * file, positioned at the sequence; length, from the header
+ * returns the number of runs, chars and starts are 1-based
+ */
+int readRuns(FILE* file, int length, char** chars, int** starts){
+	int runs = 0, n = 1, c, last = EOF;
+
+	if(!(*chars = (char*)malloc(sizeof(char) * (length + 2))) ||
+	   !(*starts = (int*)malloc(sizeof(int) * (length + 2)))){
+		printf("Error allocating row pointers for board.\n");
+		exit(4);
+	}
+	while((c = fgetc(file)) != '\n' && c != EOF){
+		if(n > length) continue;
+		if(c != last){
+			runs++;
+			(*chars)[runs] = (char)c;
+			(*starts)[runs] = n;
+			last = c;
+		}
+		n++;
+	}
+	(*chars)[0] = '/';
+	(*starts)[0] = 0;
+	(*starts)[runs + 1] = n;
+	*chars = (char*)realloc(*chars, sizeof(char) * (runs + 2));
+	*starts = (int*)realloc(*starts, sizeof(int) * (runs + 2));
+	return runs;
+}
+
+/* Function that reads the memory budget
+ * LCS_MEM_BUDGET accepts a byte count with an optional K, M or G suffix
+ * returns the budget, the physical memory when it is not set
+ */
+size_t memoryBudget(){
+	char* value = getenv("LCS_MEM_BUDGET");
+	char* suffix;
+	double budget;
+
+	if (value == NULL || *value == '\0') {
+		return (size_t)sysconf(_SC_PHYS_PAGES) * (size_t)sysconf(_SC_PAGE_SIZE);
+	}
+	budget = strtod(value, &suffix);
+	switch (*suffix) {
+		case 'G': case 'g': budget *= 1024.0 * 1024 * 1024; break;
+		case 'M': case 'm': budget *= 1024.0 * 1024; break;
+		case 'K': case 'k': budget *= 1024.0; break;
+	}
+	return (size_t)budget;
+}
+
+/* Function that turns runs back into a 1-based sequence
+ * returns the sequence, [0] = '/'
+ */
+char* expandRuns(char* chars, int* starts, int runs, int length){
+	char* vector = (char*)malloc(sizeof(char) * (length + 2));
+	int p, n;
+
+	if (vector == NULL) {
+		printf("Error allocating row pointers for board.\n");
+		exit(4);
+	}
+	vector[0] = '/';
+	for (p = 1; p <= runs; p++) {
+		for (n = starts[p]; n < starts[p + 1]; n++) vector[n] = chars[p];
+	}
+	return vector;
+}
+
+/* Function that computes the memory of the directions fill
+ * returns the peak in bytes
+ */
+size_t directionsMemory(int height, int width){
+	size_t cells = ((size_t)height + 1) * ((size_t)width + 1);
+
+	return (cells + 3) / 4 + 2 * sizeof(short) * ((size_t)width + 1) + (size_t)height + width + 4 +
+	       sizeof(short) * ((size_t)height + width + 1);
+}
+
+/* Function that computes the memory of the block boundaries
+ * Values and prefix maxima of the rows and columns, and the cost sums
+ * returns the peak in bytes
+ */
+size_t peakMemory(Board board){
+	size_t cells = ((size_t)board->runsHeight + 1) * ((size_t)board->width + 1);
+
+	cells += ((size_t)board->runsWidth + 1) * ((size_t)board->height + board->runsHeight);
+	return 2 * sizeof(int) * cells + sizeof(int) * ((size_t)board->height + board->width + 1);
+}
+
+/* Function that reads the file and builds the board
+ * Encodes both sequences as runs while reading, then allocates the block
+ * boundaries when they take less than the 2-bit directions; inputs with
+ * short runs are expanded and get the directions fill instead, and the
+ * program exits when neither fits the budget
+ * filename, the name of the file to be read
+ * returns the board
+ */
+Board parseFile(char* fileName){
+	FILE* file;
+	int height;
+	int width;
+	int c;
+	size_t n, budget, peak, directions;
+
+	if (!(file = fopen(fileName,"r"))){
+	    printf("Error opening file \"%s\"\n", fileName);
+	    exit(2);
+	}
+	if(fscanf(file, "%d %d\n", &height, &width) == 0){
+	    printf("Could not read height and width");
+	    exit(3);
+	}
+
+	Board result = (Board)calloc(1, sizeof(board_t));
+
+	result->height = height;
+	result->width = width;
+	result->runsHeight = readRuns(file, height, &result->charHeight, &result->startHeight);
+	result->runsWidth = readRuns(file, width, &result->charWidth, &result->startWidth);
+	fclose(file);
+	file = NULL;
+
+	budget = memoryBudget();
+	peak = peakMemory(result);
+	directions = directionsMemory(height, width);
+	fprintf(stderr, "plan: %d x %d runs for %d x %d, block boundaries %zu bytes (2-bit directions %zu, full matrix %zu), budget %zu bytes\n",
+	        result->runsHeight, result->runsWidth, height, width, peak, directions,
+	        sizeof(short) * ((size_t)height + 1) * ((size_t)width + 1), budget);
+	result->engine = (peak <= directions) ? RUNS : DIRECTIONS;
+	if(MIN(peak, directions) > budget){
+		fprintf(stderr, "plan: nothing fits, use lcs-ooc\n");
+		exit(5);
+	}
+	if(result->engine == RUNS && peak > budget) result->engine = DIRECTIONS;
+	if(result->engine == DIRECTIONS && directions > budget) result->engine = RUNS;
+
+	result->subsequence = (char*)malloc(sizeof(char) * (MIN(height, width) + 1));
+	result->size = 0;
+	result->costTable = (short*)malloc(sizeof(short) * (height + width + 1));
+	result->costSum = (int*)malloc(sizeof(int) * (height + width + 1));
+	for(n = 0; n < height + width + 1; n++){
+		result->costTable[n] = cost(n);
+		result->costSum[n] = result->costTable[n] + (n >= 2 ? result->costSum[n - 2] : 0);
+	}
+	if(result->engine == DIRECTIONS){
+		fprintf(stderr, "plan: the runs are too short to pay off, 2-bit directions\n");
+		result->vectorHeight = expandRuns(result->charHeight, result->startHeight, result->runsHeight, height);
+		result->vectorWidth = expandRuns(result->charWidth, result->startWidth, result->runsWidth, width);
+		if(!(result->directions = (unsigned char*)calloc((((size_t)height + 1) * ((size_t)width + 1) + 3) / 4, 1))){
+			printf("Error allocating directions for board.\n");
+			exit(4);
+		}
+		return result;
+	}
+	result->rows = (int*)calloc(((size_t)result->runsHeight + 1) * (width + 1), sizeof(int));
+	result->rowsMax = (int*)calloc(((size_t)result->runsHeight + 1) * (width + 1), sizeof(int));
+	result->columns = (int**)malloc(sizeof(int*) * (result->runsHeight + 1));
+	result->columnsMax = (int**)malloc(sizeof(int*) * (result->runsHeight + 1));
+	if(result->rows == NULL || result->rowsMax == NULL || result->columns == NULL || result->columnsMax == NULL){
+		printf("Error allocating row pointers for board.\n");
+		exit(4);
+	}
+	result->columns[0] = result->columnsMax[0] = NULL;
+	for(c = 1; c <= result->runsHeight; c++){
+		n = (size_t)result->startHeight[c + 1] - result->startHeight[c] + 1;
+		if(!(result->columns[c] = (int*)calloc(n * (result->runsWidth + 1), sizeof(int))) ||
+		   !(result->columnsMax[c] = (int*)calloc(n * (result->runsWidth + 1), sizeof(int)))){
+			printf("Error allocating row pointers for board.\n");
+			exit(4);
+		}
+	}
+
+	return result;
+}
+
+/* Function that backtracks the matrix and fills the subsequence
+ * The lcs-serial rules, on cells rebuilt from the block boundaries; the
+ * characters come out of the runs and are expanded one by one
+ * Prints out the final output
+ * board, the current board
+ */
+void printResults(board_t* board){
+	int i = board->height, j = board->width;
+	int p = board->runsHeight, q = board->runsWidth;
+	int aux = board->finalSize, up, left, n;
+
+	if(board->engine == DIRECTIONS) backtrackDirections(board);
+	while(aux > 0 && board->engine == RUNS){
+		if(board->startHeight[p] > i) p--;
+		if(board->startWidth[q] > j) q--;
+		up = cellValue(i - 1, j, p, q, board);
+		left = cellValue(i, j - 1, p, q, board);
+		if((up != aux && left != aux) || board->charHeight[p] == board->charWidth[q]){
+			board->subsequence[board->size++] = board->charHeight[p];
+			aux -= board->costTable[i + j];
+			i--;
+			j--;
+		}else if(left == aux){
+			j--;
+		}else if(up == aux){
+			i--;
+		}
+	}
+	printf("%d\n", board->finalSize);
+	for(n = board->size - 1; n >= 0; n--){
+		putchar(board->subsequence[n]);
+	}
+	printf("\n");
+}
+
+/* Function to add computation time
+ * returns 1 always
+ */
+short cost(int x){
+	int i, n_iter = 20;
+	double dcost = 0;
+	for(i = 0; i < n_iter; i++)
+		dcost += pow(sin((double) x),2) + pow(cos((double) x),2);
+	return (short) (dcost / n_iter + 0.1);
+}
+
+/*
+ * Clears the resourses used
+ */
+void cleanAll(board_t* board){
+	int p;
+
+	for(p = 1; p <= board->runsHeight && board->columns; p++){
+		free(board->columns[p]);
+		free(board->columnsMax[p]);
+	}
+	free(board->columns);
+	free(board->columnsMax);
+	free(board->rows);
+	free(board->rowsMax);
+	free(board->charHeight);
+	free(board->charWidth);
+	free(board->startHeight);
+	free(board->startWidth);
+	free(board->costTable);
+	free(board->costSum);
+	free(board->vectorHeight);
+	free(board->vectorWidth);
+	free(board->directions);
+	free(board->subsequence);
+	free(board);
+}
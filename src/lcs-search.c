@@ -0,0 +1,431 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <omp.h>
+
+#define MAX(x, y) ( ((x) > (y)) ? (x) : (y) )
+
+#define WORD_BITS 64
+#define BATCH_SIZE 256
+#define DEFAULT_TOP 10
+
+typedef uint64_t word_t;
+
+/* The query is parsed once and reused for every target:
+ * one match bitmask per symbol (bit i set when vectorHeight[i+1] == symbol)
+ * and the cost() values indexed by i+j
+ */
+typedef struct {
+	int height;
+	int words;
+	char* vectorHeight;
+	word_t* masks;		//256 * words
+	short* costTable;
+	int costLength;
+	short unitCost;		//1 if every cost entry is 1, otherwise 0
+}profile_t;
+
+typedef profile_t* Profile;
+
+typedef struct {
+	long record;
+	int width;
+	char* vectorWidth;
+	int score;
+}target_t;
+
+typedef target_t* Target;
+
+short cost(int x);
+Profile parseQuery(char* fileName);
+void growCostTable(Profile profile, int maxWidth);
+int readBatch(FILE* file, target_t* batch, long* nextRecord);
+int scoreBitParallel(Profile profile, Target target);
+int scoreLinear(Profile profile, Target target);
+int scoreTarget(Profile profile, Target target);
+void insertTop(target_t* top, int* topSize, int k, Target target);
+void printSubsequence(Profile profile, Target target);
+void printResults(Profile profile, target_t* top, int topSize, long records, short withSubsequence);
+void cleanAll(Profile profile, target_t* top, int topSize);
+
+int main(int argc, char* argv[]){
+
+	FILE* file;
+	char* queryName;
+	char* targetsName;
+	int k = DEFAULT_TOP;
+	short withSubsequence = 0;
+	char* end;
+	target_t batch[BATCH_SIZE];
+	target_t* top;
+	int topSize = 0;
+	int batchSize, maxWidth, n;
+	long records = 0;
+
+	if(argc < 3){
+		printf("Usage: %s query.in targets.in [k] [-s]\n", argv[0]);
+		exit(1);
+	}
+	queryName = argv[1];
+	targetsName = argv[2];
+	for(n = 3; n < argc; n++){
+		if(!strcmp(argv[n], "-s")){
+			withSubsequence = 1;
+			continue;
+		}
+		k = (int)strtol(argv[n], &end, 10);
+		if(*argv[n] == '\0' || *end != '\0'){
+			printf("Usage: %s query.in targets.in [k] [-s]\n", argv[0]);
+			exit(1);
+		}
+	}
+	if(k < 1) k = 1;
+
+	Profile profile = parseQuery(queryName);
+	if (!(file = fopen(targetsName,"r"))){
+		printf("Error opening file \"%s\"\n", targetsName);
+		exit(2);
+	}
+	top = (target_t*)malloc(sizeof(target_t) * (k + 1));
+
+	while((batchSize = readBatch(file, batch, &records)) > 0){
+		maxWidth = 0;
+		for(n = 0; n < batchSize; n++){
+			maxWidth = MAX(maxWidth, batch[n].width);
+		}
+		growCostTable(profile, maxWidth);
+
+#pragma omp parallel for schedule(dynamic, 1)
+		for(n = 0; n < batchSize; n++){
+			batch[n].score = scoreTarget(profile, &batch[n]);
+		}
+
+		for(n = 0; n < batchSize; n++){
+			insertTop(top, &topSize, k, &batch[n]);
+		}
+	}
+	fclose(file);
+	file = NULL;
+
+	printResults(profile, top, topSize, records, withSubsequence);
+	cleanAll(profile, top, topSize);
+	return 0;
+}
+
+/* Function that reads the query and precomputes its profile
+ * The query file holds the length on the first line and the sequence on the second
+ * Builds one match bitmask per symbol over the query positions
+ * fileName, the name of the file to be read
+ * returns the profile
+ */
+Profile parseQuery(char* fileName){
+	FILE* file;
+	int height;
+	int c, words;
+	char* vectorHeight;
+	word_t* masks;
+	size_t n = 1;
+
+	if (!(file = fopen(fileName,"r"))){
+	    printf("Error opening file \"%s\"\n", fileName);
+	    exit(2);
+	}
+	if(fscanf(file, "%d\n", &height) != 1 || height < 1){
+	    printf("Could not read query length");
+	    exit(3);
+	}
+	words = (height + WORD_BITS - 1) / WORD_BITS;
+	if(!(vectorHeight = (char*) malloc(sizeof(char)*(height + 1)))||
+	   !(masks = (word_t*) calloc(256 * (size_t)words, sizeof(word_t)))){
+		    printf("Error allocating query profile.\n");
+		    exit(4);
+	}
+
+	while((c = fgetc(file)) != '\n' && c != EOF){
+		if(n <= height) vectorHeight[n++] = (char)c;
+	}
+	if(n <= height){
+	    printf("Query is shorter than its length\n");
+	    exit(3);
+	}
+	vectorHeight[0] = '/';
+	fclose(file);
+	file = NULL;
+
+	for(n = 1; n <= height; n++){
+		c = (unsigned char)vectorHeight[n];
+		masks[c * words + (n - 1) / WORD_BITS] |= (word_t)1 << ((n - 1) % WORD_BITS);
+	}
+
+	Profile result = (Profile)malloc(sizeof(profile_t));
+
+	result->height = height;
+	result->words = words;
+	result->vectorHeight = vectorHeight;
+	result->masks = masks;
+	result->costTable = NULL;
+	result->costLength = 0;
+	result->unitCost = 1;
+
+	return result;
+}
+
+/* Extends the cost table so it covers every i+j of a target of maxWidth
+ * Called outside the parallel region, the table is read-only while scoring
+ * profile, the query profile; maxWidth, the widest target of the batch
+ */
+void growCostTable(Profile profile, int maxWidth){
+	int length = profile->height + maxWidth + 1;
+	int x;
+
+	if(length <= profile->costLength) return;
+	if(!(profile->costTable = (short*)realloc(profile->costTable, sizeof(short) * length))){
+		printf("Error allocating cost table.\n");
+		exit(4);
+	}
+	for(x = profile->costLength; x < length; x++){
+		profile->costTable[x] = cost(x);
+		if(x >= 2 && profile->costTable[x] != 1) profile->unitCost = 0;
+	}
+	profile->costLength = length;
+}
+
+/* Function that reads up to BATCH_SIZE targets
+ * Each record is a length line followed by a sequence line
+ * file, the targets file; batch, where to store them; nextRecord, the record counter
+ * returns the number of targets read
+ */
+int readBatch(FILE* file, target_t* batch, long* nextRecord){
+	int count = 0;
+	int width, c;
+	size_t n;
+
+	while(count < BATCH_SIZE && fscanf(file, "%d", &width) == 1){
+		if(width < 0){
+			printf("Invalid target length in record %ld\n", *nextRecord);
+			exit(3);
+		}
+		if(!(batch[count].vectorWidth = (char*)malloc(sizeof(char) * (width + 1)))){
+			printf("Error allocating target.\n");
+			exit(4);
+		}
+		while((c = fgetc(file)) != '\n' && c != EOF);
+		n = 1;
+		while((c = fgetc(file)) != '\n' && c != EOF){
+			if(n <= width) batch[count].vectorWidth[n++] = (char)c;
+		}
+		if(n <= width){
+			printf("Record %ld is shorter than its length\n", *nextRecord);
+			exit(3);
+		}
+		batch[count].vectorWidth[0] = '/';
+		batch[count].width = width;
+		batch[count].record = (*nextRecord)++;
+		batch[count].score = 0;
+		count++;
+	}
+	return count;
+}
+
+/* Bit-parallel LCS length (Allison-Dix / Hyyro) with the query as bit vector
+ * Only valid when every cost entry is 1
+ * profile, the query profile; target, the target being scored
+ * returns the LCS length
+ */
+int scoreBitParallel(Profile profile, Target target){
+	int words = profile->words;
+	int tail = profile->height % WORD_BITS;
+	word_t* row = (word_t*)malloc(sizeof(word_t) * words);
+	word_t* match;
+	word_t u, sum, carry, borrow, diff;
+	int j, w, result = 0;
+
+	for(w = 0; w < words; w++) row[w] = ~(word_t)0;
+
+	for(j = 1; j <= target->width; j++){
+		match = profile->masks + (unsigned char)target->vectorWidth[j] * words;
+		carry = 0;
+		borrow = 0;
+		for(w = 0; w < words; w++){
+			u = row[w] & match[w];
+			sum = row[w] + u + carry;
+			carry = (sum < row[w]) || (carry && sum == row[w]);
+			diff = row[w] - u - borrow;
+			borrow = (row[w] < u) || (borrow && row[w] == u);
+			row[w] = sum | diff;
+		}
+	}
+
+	if(tail) row[words - 1] |= ~(word_t)0 << tail;
+	for(w = 0; w < words; w++){
+		result += __builtin_popcountll(~row[w]);
+	}
+	free(row);
+	return result;
+}
+
+/* Linear-space LCS with the precomputed cost table
+ * Used when the cost model is not unitary
+ * profile, the query profile; target, the target being scored
+ * returns the final matrix value
+ */
+int scoreLinear(Profile profile, Target target){
+	int width = target->width;
+	short* above = (short*)calloc(width + 1, sizeof(short));
+	short* current = (short*)calloc(width + 1, sizeof(short));
+	short* swap;
+	int i, j, result;
+
+	for(i = 1; i <= profile->height; i++){
+		current[0] = 0;
+		for(j = 1; j <= width; j++){
+			if(profile->vectorHeight[i] == target->vectorWidth[j]){
+				current[j] = above[j - 1] + profile->costTable[i + j];
+			}else{
+				current[j] = MAX(above[j], current[j - 1]);
+			}
+		}
+		swap = above;
+		above = current;
+		current = swap;
+	}
+	result = above[width];
+	free(above);
+	free(current);
+	return result;
+}
+
+/* Scores one target with the reused query profile
+ * profile, the query profile; target, the target being scored
+ * returns the score
+ */
+int scoreTarget(Profile profile, Target target){
+	if(target->width == 0) return 0;
+	if(profile->unitCost) return scoreBitParallel(profile, target);
+	return scoreLinear(profile, target);
+}
+
+/* Keeps the k best targets sorted by score, ties by record order
+ * Targets that do not make it are freed
+ * top, the ranking; topSize, its size; k, the limit; target, the candidate
+ */
+void insertTop(target_t* top, int* topSize, int k, Target target){
+	int n = *topSize;
+
+	while(n > 0 && top[n - 1].score < target->score){
+		top[n] = top[n - 1];
+		n--;
+	}
+	top[n] = *target;
+	if(*topSize < k){
+		(*topSize)++;
+	}else{
+		free(top[k].vectorWidth);
+	}
+}
+
+/* Recomputes the full matrix of one ranked target and backtracks it
+ * Applies the same backtracking rules as lcs-serial
+ * profile, the query profile; target, the ranked target
+ */
+void printSubsequence(Profile profile, Target target){
+	int height = profile->height;
+	int width = target->width;
+	int heightLength = height;
+	int widthLength = width;
+	char* vectorHeight = profile->vectorHeight;
+	char* vectorWidth = target->vectorWidth;
+	int i, j, aux, finalSize;
+	short int** matrix = (short int**)malloc(sizeof(short int*) * (height + 1));
+	char* subsequence;
+
+	for(i = 0; i <= height; i++){
+		if(!(matrix[i] = (short int*)malloc(sizeof(short int) * (width + 1)))){
+			printf("Error allocating matrix for record %ld.\n", target->record);
+			exit(4);
+		}
+		for(j = 0; j <= width; j++){
+			if (i == 0 || j == 0) {
+				matrix[i][j] = 0;
+			} else if (vectorHeight[i] == vectorWidth[j]) {
+				matrix[i][j] = matrix[i - 1][j - 1] + profile->costTable[i + j];
+			}else{
+				matrix[i][j] = MAX(matrix[i - 1][j], matrix[i][j - 1]);
+			}
+		}
+	}
+
+	finalSize = matrix[height][width];
+	subsequence = (char*) malloc(sizeof(char) * (finalSize + 1));
+	aux = finalSize;
+	while(aux > 0){
+		if((matrix[heightLength-1][widthLength] != aux) &&
+		   (matrix[heightLength][widthLength-1] != aux)){
+			subsequence[aux -1] = vectorHeight[heightLength];
+			heightLength--;
+			widthLength--;
+			aux--;
+		}else if (vectorHeight[heightLength] == vectorWidth[widthLength]) {
+			subsequence[aux -1] = vectorHeight[heightLength];
+			heightLength--;
+			widthLength--;
+			aux--;
+		}else if (matrix[heightLength][widthLength-1] == aux) {
+			widthLength--;
+		}else if (matrix[heightLength-1][widthLength] == aux) {
+			heightLength--;
+		}
+	}
+	subsequence[finalSize] = '\0';
+	printf("%s\n", subsequence);
+
+	free(subsequence);
+	for(i = 0; i <= height; i++){
+		free(matrix[i]);
+	}
+	free(matrix);
+}
+
+/* Prints the ranking, one "record score width" line per target
+ * With -s the subsequence of each ranked target follows its line
+ */
+void printResults(Profile profile, target_t* top, int topSize, long records, short withSubsequence){
+	int n;
+
+	printf("%ld targets\n", records);
+	for(n = 0; n < topSize; n++){
+		printf("%ld %d %d\n", top[n].record, top[n].score, top[n].width);
+		if(withSubsequence){
+			printSubsequence(profile, &top[n]);
+		}
+	}
+}
+
+/* Function to add computation time
+ * returns 1 always
+ */
+short cost(int x){
+	int i, n_iter = 20;
+	double dcost = 0;
+	for(i = 0; i < n_iter; i++)
+		dcost += pow(sin((double) x),2) + pow(cos((double) x),2);
+	return (short) (dcost / n_iter + 0.1);
+}
+
+/*
+ * Clears the resourses used
+ */
+void cleanAll(Profile profile, target_t* top, int topSize){
+	int n;
+
+	for(n = 0; n < topSize; n++){
+		free(top[n].vectorWidth);
+	}
+	free(top);
+	free(profile->vectorHeight);
+	free(profile->masks);
+	free(profile->costTable);
+	free(profile);
+}
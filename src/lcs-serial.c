@@ -1,8 +1,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <unistd.h>
+#include <string.h>
 
 #define MAX(x, y) ( ((x) > (y)) ? (x) : (y) )
+#define MIN(x, y) ( ((x) > (y)) ? (y) : (x) )
+
+#define FULL_MATRIX 0
+#define DIRECTIONS -1
+
+#define DIAGONAL 0
+#define LEFT 1
+#define UP 2
 
 typedef struct {
 	int height;
@@ -10,6 +20,11 @@ typedef struct {
 	char* vectorHeight;
 	char* vectorWidth;
 	short int** matrix;
+	int step;		//rows between checkpoints, FULL_MATRIX keeps every row, DIRECTIONS 2 bits per cell
+	unsigned char* directions;	//4 cells per byte, row major
+	short int** checkpoints;
+	short int** buffer;	//step + 1 rows reused by the fill and the backtrack
+	int loadedBlock;
 }board_t;
 
 typedef board_t* Board;
@@ -20,6 +35,12 @@ void processCell(int i, int j, Board board);
 void printResults(board_t* board);
 void iterateBoard(board_t* board);
 void cleanAll(board_t* board);
+size_t memoryBudget();
+size_t peakMemory(int height, int width, int step);
+int planMemory(int height, int width);
+void loadBlock(int i, board_t* board);
+void recordDirection(int i, int j, Board board);
+int getDirection(int i, int j, Board board);
 
 int main(int argc, char* argv[]){
 
@@ -55,12 +76,167 @@ void processCell(int i, int j, Board board){
 void iterateBoard(board_t* board){
 	int heightLength = board->height + 1;
 	int widthLength = board->width + 1;
+	int step = board->step;
 	size_t i, j;
 	for (i = 0; i < heightLength; ++i) {
+		if (step == DIRECTIONS) {
+			board->matrix[i] = board->buffer[i % 2];
+		} else if (step != FULL_MATRIX) {
+			board->matrix[i] = (i % step == 0) ? board->checkpoints[i / step] : board->buffer[i % 2];
+		}
 		for (j = 0; j < widthLength; ++j) {
 			processCell(i, j, board);
+			if (step == DIRECTIONS && i > 0 && j > 0) {
+				recordDirection(i, j, board);
+			}
+		}
+	}
+	board->loadedBlock = -1;
+}
+
+/* Function that stores the move the backtrack makes from a cell
+ * Same rules as printResults, where the value followed along the path
+ * is the value of the cell itself
+ * i, the line; j, the column; board, the current board
+ */
+void recordDirection(int i, int j, Board board){
+	short int** matrix = board->matrix;
+	short int value = matrix[i][j];
+	size_t cell = (size_t)i * (board->width + 1) + j;
+	int direction;
+
+	if ((matrix[i - 1][j] != value) && (matrix[i][j - 1] != value)) {
+		direction = DIAGONAL;
+	} else if (board->vectorHeight[i] == board->vectorWidth[j]) {
+		direction = DIAGONAL;
+	} else if (matrix[i][j - 1] == value) {
+		direction = LEFT;
+	} else {
+		direction = UP;
+	}
+	board->directions[cell / 4] |= direction << (2 * (cell % 4));
+}
+
+/* Reads the move stored for a cell
+ * i, the line; j, the column; board, the current board
+ * returns DIAGONAL, LEFT or UP
+ */
+int getDirection(int i, int j, Board board){
+	size_t cell = (size_t)i * (board->width + 1) + j;
+
+	return (board->directions[cell / 4] >> (2 * (cell % 4))) & 3;
+}
+
+/* Function that makes rows i-1 and i of a checkpointed board readable
+ * Recomputes the block of rows that follows the checkpoint above row i
+ * Does nothing when the whole matrix is kept
+ * i, the line; board, the current board
+ */
+void loadBlock(int i, board_t* board){
+	int step = board->step;
+	int block, first, r;
+	size_t j;
+
+	if (step == FULL_MATRIX || step == DIRECTIONS) return;
+	block = (i - 1) / step;
+	if (block == board->loadedBlock) return;
+
+	first = block * step;
+	board->matrix[first] = board->checkpoints[block];
+	for (r = 1; r <= step && first + r <= board->height; ++r) {
+		board->matrix[first + r] = board->buffer[r];
+		for (j = 0; j <= board->width; ++j) {
+			processCell(first + r, j, board);
 		}
 	}
+	board->loadedBlock = block;
+}
+
+/* Function that reads the memory budget
+ * LCS_MEM_BUDGET accepts a byte count with an optional K, M or G suffix
+ * returns the budget, the physical memory when it is not set
+ */
+size_t memoryBudget(){
+	char* value = getenv("LCS_MEM_BUDGET");
+	char* suffix;
+	double budget;
+
+	if (value == NULL || *value == '\0') {
+		return (size_t)sysconf(_SC_PHYS_PAGES) * (size_t)sysconf(_SC_PAGE_SIZE);
+	}
+	budget = strtod(value, &suffix);
+	switch (*suffix) {
+		case 'G': case 'g': budget *= 1024.0 * 1024 * 1024; break;
+		case 'M': case 'm': budget *= 1024.0 * 1024; break;
+		case 'K': case 'k': budget *= 1024.0; break;
+	}
+	return (size_t)budget;
+}
+
+/* Function that computes the peak memory of the board
+ * Counts the sequences, the row pointers, the stored rows and the subsequence
+ * height, width the sizes; step, the checkpoint step, FULL_MATRIX or DIRECTIONS
+ * returns the peak in bytes
+ */
+size_t peakMemory(int height, int width, int step){
+	size_t rowBytes = sizeof(short int) * ((size_t)width + 1);
+	size_t rows;
+	size_t bytes = sizeof(board_t) + (size_t)height + 1 + (size_t)width + 1;
+
+	bytes += sizeof(short int*) * ((size_t)height + 1);
+	bytes += sizeof(char) * (size_t)MIN(height, width);
+	if (step == FULL_MATRIX) {
+		rows = (size_t)height + 1;
+	} else if (step == DIRECTIONS) {
+		rows = 2;
+		bytes += sizeof(short int*) * 2;
+		bytes += (((size_t)height + 1) * ((size_t)width + 1) + 3) / 4;
+	} else {
+		rows = (size_t)height / step + 1 + (size_t)step + 1;
+		bytes += sizeof(short int*) * ((size_t)height / step + 1 + (size_t)step + 1);
+	}
+	return bytes + rows * rowBytes;
+}
+
+/* Function that picks the engine before anything is allocated
+ * Keeps the full matrix when it fits the budget, then two rows and a
+ * 2-bit direction per cell, otherwise checkpoints every sqrt(height) rows
+ * and recomputes blocks during the backtrack
+ * LCS_ENGINE set to full, directions or checkpoint forces an engine
+ * Reports the plan on stderr and exits when nothing fits
+ * height, width the sizes
+ * returns the checkpoint step, FULL_MATRIX or DIRECTIONS
+ */
+int planMemory(int height, int width){
+	size_t budget = memoryBudget();
+	size_t full = peakMemory(height, width, FULL_MATRIX);
+	size_t directions = peakMemory(height, width, DIRECTIONS);
+	char* engine = getenv("LCS_ENGINE");
+	int step = MAX(1, (int)ceil(sqrt((double)height)));
+	size_t checkpointed = peakMemory(height, width, step);
+
+	if (engine == NULL) engine = "";
+	if (*engine && strcmp(engine, "full") && strcmp(engine, "directions") && strcmp(engine, "checkpoint")) {
+		fprintf(stderr, "Unknown LCS_ENGINE \"%s\", use full, directions or checkpoint\n", engine);
+		exit(1);
+	}
+	if (!strcmp(engine, "full") || (!*engine && full <= budget)) {
+		fprintf(stderr, "plan: full matrix, peak %zu bytes, budget %zu bytes\n", full, budget);
+		return FULL_MATRIX;
+	}
+	if (!strcmp(engine, "directions") || (!*engine && directions <= budget)) {
+		fprintf(stderr, "plan: 2-bit directions, peak %zu bytes (full matrix %zu), budget %zu bytes\n",
+		        directions, full, budget);
+		return DIRECTIONS;
+	}
+	if (!strcmp(engine, "checkpoint") || (!*engine && checkpointed <= budget)) {
+		fprintf(stderr, "plan: checkpoint every %d rows, peak %zu bytes (full matrix %zu), budget %zu bytes\n",
+		        step, checkpointed, full, budget);
+		return step;
+	}
+	fprintf(stderr, "plan: no engine fits, full matrix %zu bytes, checkpointed %zu bytes, budget %zu bytes, use lcs-ooc\n",
+	        full, checkpointed, budget);
+	exit(5);
 }
 
 /* Function that reads the file and builds the board
@@ -76,6 +252,10 @@ Board parseFile(char* fileName){
 	char* vectorHeight;
 	char* vectorWeidth;
 	short int** matrix;
+	short int** checkpoints = NULL;
+	short int** buffer = NULL;
+	unsigned char* directions = NULL;
+	int step;
 	size_t n = 1;
 
 
@@ -87,6 +267,7 @@ Board parseFile(char* fileName){
 	    printf("Could not read height and width");
 	    exit(3);
 	}
+	step = planMemory(height, width);
 	if(!(vectorHeight = (char*) malloc(sizeof(char)*(height + 1)))||
 	   !(vectorWeidth = (char*) malloc(sizeof(char)*(width + 1)))){
 		    printf("Error allocating row pointers for board.\n");
@@ -105,8 +286,28 @@ Board parseFile(char* fileName){
 	vectorWeidth[0] = '/';
 
 	matrix = (short int**)malloc(sizeof(short int*) * (height + 1));
-	for (n = 0; n < height + 1; ++n) {
-		matrix[n] = (short int*)malloc(sizeof(short int) * (width + 1));
+	if (step == FULL_MATRIX) {
+		for (n = 0; n < height + 1; ++n) {
+			matrix[n] = (short int*)malloc(sizeof(short int) * (width + 1));
+		}
+	} else if (step == DIRECTIONS) {
+		buffer = (short int**)malloc(sizeof(short int*) * 2);
+		for (n = 0; n < 2; ++n) {
+			buffer[n] = (short int*)malloc(sizeof(short int) * (width + 1));
+		}
+		if (!(directions = (unsigned char*)calloc((((size_t)height + 1) * (width + 1) + 3) / 4, 1))) {
+			printf("Error allocating directions for board.\n");
+			exit(4);
+		}
+	} else {
+		checkpoints = (short int**)malloc(sizeof(short int*) * (height / step + 1));
+		for (n = 0; n < height / step + 1; ++n) {
+			checkpoints[n] = (short int*)malloc(sizeof(short int) * (width + 1));
+		}
+		buffer = (short int**)malloc(sizeof(short int*) * (step + 1));
+		for (n = 0; n < step + 1; ++n) {
+			buffer[n] = (short int*)malloc(sizeof(short int) * (width + 1));
+		}
 	}
 	fclose(file);
 	file = NULL;
@@ -118,6 +319,11 @@ Board parseFile(char* fileName){
 	result->matrix = matrix;
 	result->vectorHeight = vectorHeight;
 	result->vectorWidth = vectorWeidth;
+	result->step = step;
+	result->checkpoints = checkpoints;
+	result->buffer = buffer;
+	result->directions = directions;
+	result->loadedBlock = -1;
 
 	return result;
 
@@ -154,7 +360,23 @@ void printResults(board_t* board){
 	/* just for testing */
 
 	aux = finalSize;
+	while(aux > 0 && board->step == DIRECTIONS){
+		switch(getDirection(heightLength, widthLength, board)){
+			case DIAGONAL:
+				subsequence[aux -1] = board->vectorHeight[heightLength];
+				heightLength--;
+				widthLength--;
+				aux--;
+				break;
+			case LEFT:
+				widthLength--;
+				break;
+			default:
+				heightLength--;
+		}
+	}
 	while(aux > 0){
+		loadBlock(heightLength, board);
 		if((matrix[heightLength-1][widthLength] != aux) &&
 		   (matrix[heightLength][widthLength-1] != aux)){
 			subsequence[aux -1] = board->vectorHeight[heightLength];
@@ -204,8 +426,25 @@ void cleanAll(board_t* board){
 	free(board->vectorHeight);
 	free(board->vectorWidth);
 
-	for(n = 0; n < board->height; n++){
-		free(board->matrix[n]);
+	if(board->step == FULL_MATRIX){
+		for(n = 0; n <= board->height; n++){
+			free(board->matrix[n]);
+		}
+	}else if(board->step == DIRECTIONS){
+		for(n = 0; n < 2; n++){
+			free(board->buffer[n]);
+		}
+		free(board->buffer);
+		free(board->directions);
+	}else{
+		for(n = 0; n < board->height / board->step + 1; n++){
+			free(board->checkpoints[n]);
+		}
+		for(n = 0; n < board->step + 1; n++){
+			free(board->buffer[n]);
+		}
+		free(board->checkpoints);
+		free(board->buffer);
 	}
 	free(board->matrix);
 
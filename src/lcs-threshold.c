@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define MAX(x, y) ( ((x) > (y)) ? (x) : (y) )
+#define MIN(x, y) ( ((x) > (y)) ? (y) : (x) )
+
+#define TILE 256
+
+#define REACHED 1
+#define UNREACHABLE 2
+
+typedef struct {
+	int height;
+	int width;
+	char* vectorHeight;
+	char* vectorWidth;
+	short* costTable;
+	short maxCost;
+	int threshold;
+	short* row;		//bottom boundary of the last band, lower bounds
+	long long evaluated;
+	long long skipped;
+}board_t;
+
+typedef board_t* Board;
+
+short cost(int x);
+Board parseFile(char* fileName, int threshold);
+int upperBound(int value, int i, int j, Board board);
+short processTile(int i0, int i1, int j0, int j1, short* leftColumn, short corner, Board board);
+short skipTile(int i0, int i1, int j0, int j1, short* leftColumn, Board board);
+int iterateBoard(board_t* board);
+void printResults(board_t* board, int decision);
+void cleanAll(board_t* board);
+
+int main(int argc, char* argv[]){
+
+	if(argc < 3){
+		printf("Usage: %s file.in k\n", argv[0]);
+		exit(1);
+	}
+	char* fileName = argv[1];
+	Board board = parseFile(fileName, atoi(argv[2]));
+	int decision = iterateBoard(board);
+	printResults(board, decision);
+	cleanAll(board);
+	return 0;
+}
+
+/* Upper bound of the final value through cell (i, j)
+ * Every remaining match can add at most maxCost
+ * value, a lower bound of the cell; i, j the coordinates; board, the current board
+ */
+int upperBound(int value, int i, int j, Board board){
+	return value + board->maxCost * MIN(board->height - i, board->width - j);
+}
+
+/* Function that fills a tile row by row in the board row vector
+ * leftColumn holds column j0-1 for rows i0..i1 and receives column j1
+ * corner, the value at (i0-1, j0-1)
+ * returns the largest value found in the tile
+ */
+short processTile(int i0, int i1, int j0, int j1, short* leftColumn, short corner, Board board){
+	short* row = board->row;
+	short diag, left, up, value, above = corner, best = 0;
+	int i, j;
+
+	for(i = i0; i <= i1; i++){
+		diag = above;
+		left = leftColumn[i - i0];
+		above = left;
+		for(j = j0; j <= j1; j++){
+			up = row[j];
+			if(board->vectorHeight[i] == board->vectorWidth[j]){
+				value = diag + board->costTable[i + j];
+			}else{
+				value = MAX(up, left);
+			}
+			diag = up;
+			row[j] = value;
+			left = value;
+		}
+		leftColumn[i - i0] = left;
+		best = MAX(best, left);
+	}
+	board->evaluated += (long long)(i1 - i0 + 1) * (j1 - j0 + 1);
+	return best;
+}
+
+/* Function that fills the outputs of a tile no path of value >= k can cross
+ * The bottom row and right column get lower bounds, since the matrix
+ * only grows to the right and downwards
+ * returns the largest value written
+ */
+short skipTile(int i0, int i1, int j0, int j1, short* leftColumn, Board board){
+	short* row = board->row;
+	short bottomLeft = leftColumn[i1 - i0];
+	short rightTop = row[j1];
+	short running = 0;
+	int i, j;
+
+	for(j = j0; j <= j1; j++){
+		running = MAX(running, row[j]);
+		row[j] = MAX(running, bottomLeft);
+	}
+	running = 0;
+	for(i = i0; i <= i1; i++){
+		running = MAX(running, leftColumn[i - i0]);
+		leftColumn[i - i0] = MAX(running, rightTop);
+	}
+	board->skipped += (long long)(i1 - i0 + 1) * (j1 - j0 + 1);
+	return row[j1];
+}
+
+/* Function that iterates through the matrix in bands of TILE rows
+ * A tile is skipped when its boundary cannot reach k
+ * Stops as soon as a value reaches k or a whole band bottom cannot
+ * returns REACHED or UNREACHABLE
+ */
+int iterateBoard(board_t* board){
+	int height = board->height;
+	int width = board->width;
+	int k = board->threshold;
+	short* row = board->row;
+	short* leftColumn;
+	short corner, nextCorner, boundary, best;
+	int i0, i1, j0, j1, j, n;
+
+	if(k <= 0) return REACHED;
+	if(upperBound(0, 0, 0, board) < k) return UNREACHABLE;
+	leftColumn = (short*)malloc(sizeof(short) * TILE);
+
+	for(i0 = 1; i0 <= height; i0 += TILE){
+		i1 = MIN(i0 + TILE - 1, height);
+		for(n = 0; n <= i1 - i0; n++) leftColumn[n] = 0;
+		corner = 0;
+		for(j0 = 1; j0 <= width; j0 += TILE){
+			j1 = MIN(j0 + TILE - 1, width);
+			nextCorner = row[j1];
+
+			boundary = corner;
+			for(j = j0; j <= j1; j++) boundary = MAX(boundary, row[j]);
+			for(n = 0; n <= i1 - i0; n++) boundary = MAX(boundary, leftColumn[n]);
+
+			if(upperBound(boundary, i0 - 1, j0 - 1, board) < k){
+				best = skipTile(i0, i1, j0, j1, leftColumn, board);
+			}else{
+				best = processTile(i0, i1, j0, j1, leftColumn, corner, board);
+			}
+			if(best >= k){
+				free(leftColumn);
+				return REACHED;
+			}
+			corner = nextCorner;
+		}
+
+		for(j = 0; j <= width; j++){
+			if(upperBound(row[j], i1, j, board) >= k) break;
+		}
+		if(j > width){
+			free(leftColumn);
+			return UNREACHABLE;
+		}
+	}
+	free(leftColumn);
+	return (row[width] >= k) ? REACHED : UNREACHABLE;
+}
+
+/* Function that reads the file and builds the board
+ * Builds the vertical and horizontal string and the cost table
+ * Only one row of the matrix is kept
+ * filename, the name of the file to be read; threshold, the k to decide
+ * returns the board
+ */
+Board parseFile(char* fileName, int threshold){
+	FILE* file;
+	int height;
+	int width;
+	int c;
+	char* vectorHeight;
+	char* vectorWeidth;
+	short* costTable;
+	short maxCost = 0;
+	size_t n = 1;
+
+
+	if (!(file = fopen(fileName,"r"))){
+	    printf("Error opening file \"%s\"\n", fileName);
+	    exit(2);
+	}
+	if(fscanf(file, "%d %d\n", &height, &width) == 0){
+	    printf("Could not read height and width");
+	    exit(3);
+	}
+	if(!(vectorHeight = (char*) malloc(sizeof(char)*(height + 1)))||
+	   !(vectorWeidth = (char*) malloc(sizeof(char)*(width + 1)))){
+		    printf("Error allocating row pointers for board.\n");
+		    exit(4);
+	}
+
+	while((c = fgetc(file)) != '\n'){
+		 vectorHeight[n++] = (char)c;
+	}
+	vectorHeight[0] = '/';
+
+	n = 1;
+	while((c = fgetc(file)) != '\n'){
+		vectorWeidth[n++] = (char)c;
+	}
+	vectorWeidth[0] = '/';
+	fclose(file);
+	file = NULL;
+
+	costTable = (short*)malloc(sizeof(short) * (height + width + 1));
+	for(n = 0; n < height + width + 1; n++){
+		costTable[n] = cost(n);
+		if(n >= 2) maxCost = MAX(maxCost, costTable[n]);
+	}
+
+	Board result = (Board)malloc(sizeof(board_t));
+
+	result->height =  height;
+	result->width = width;
+	result->vectorHeight = vectorHeight;
+	result->vectorWidth = vectorWeidth;
+	result->costTable = costTable;
+	result->maxCost = maxCost;
+	result->threshold = threshold;
+	result->row = (short*)calloc(width + 1, sizeof(short));
+	result->evaluated = 0;
+	result->skipped = 0;
+
+	return result;
+
+}
+
+/* Prints the decision and how much of the matrix was evaluated
+ * board, the current board; decision, REACHED or UNREACHABLE
+ */
+void printResults(board_t* board, int decision){
+	long long total = (long long)board->height * board->width;
+
+	printf("%s\n", (decision == REACHED) ? "yes" : "no");
+	printf("evaluated %lld of %lld cells (%.2f%%), skipped %lld\n",
+	       board->evaluated, total,
+	       total ? 100.0 * board->evaluated / total : 0.0,
+	       board->skipped);
+}
+
+/* Function to add computation time
+ * returns 1 always
+ */
+short cost(int x){
+	int i, n_iter = 20;
+	double dcost = 0;
+	for(i = 0; i < n_iter; i++)
+		dcost += pow(sin((double) x),2) + pow(cos((double) x),2);
+	return (short) (dcost / n_iter + 0.1);
+}
+
+/*
+ * Clears the resourses used
+ */
+void cleanAll(board_t* board){
+
+	free(board->vectorHeight);
+	free(board->vectorWidth);
+	free(board->costTable);
+	free(board->row);
+	free(board);
+}